@@ -4,9 +4,12 @@
 #include "G4RunManager.hh"
 #endif
 
+#include "G4StateManager.hh"
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
+#include "G4VStateDependent.hh"
 #include "G4VisExecutive.hh"
+#include "Randomize.hh"
 
 #include "PhononPhysicsList.hh"
 #include "G4CMPConfigManager.hh"
@@ -15,13 +18,101 @@
 #include "PhononDetectorConstruction.hh"
 #include "PhononSteppingAction.hh"
 
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace {
+  void PrintUsage(const char* prog) {
+    G4cerr << "Usage: " << prog << " [options] [macro]\n"
+           << "  --headless        No visualization or UI session\n"
+           << "  -t, --threads N   Number of worker threads (default: all cores)\n"
+           << "                    (/run/numberOfThreads in the macro overrides this)\n"
+           << "  -s, --seed N      Random number seed\n"
+           << "  -n, --events N    Run N events after the macro (if any)\n"
+           << "  -o, --output DIR  Directory for all output files\n"
+           << "  -h, --help        Show this message\n"
+           << "With no macro and no --headless, an interactive session is started."
+           << G4endl;
+  }
+
+  // Reports time from program start to the end of /run/initialize, from
+  // whichever of macro, -n or interactive session issued it.  The thread
+  // count is fixed by then, so a -t overridden by /run/numberOfThreads in
+  // the macro is caught here, before any events run.
+  class StartupReport : public G4VStateDependent {
+  public:
+    StartupReport(G4int threads)
+      : start(std::chrono::steady_clock::now()), requestedThreads(threads),
+        done(false) {;}
+
+    virtual G4bool Notify(G4ApplicationState requestedState) {
+      if (done || requestedState != G4State_Idle ||
+          G4StateManager::GetStateManager()->GetCurrentState() != G4State_Init)
+        return true;
+
+      done = true;
+      G4cout << "----> Startup took "
+             << std::chrono::duration<G4double, std::milli>(
+                  std::chrono::steady_clock::now() - start).count()
+             << " ms" << G4endl;
+
+#ifdef G4MULTITHREADED
+      G4int nThreads = G4MTRunManager::GetMasterRunManager()->GetNumberOfThreads();
+      if (requestedThreads > 0 && nThreads != requestedThreads) {
+        G4ExceptionDescription msg;
+        msg << "--threads " << requestedThreads
+            << " was overridden by /run/numberOfThreads; running with "
+            << nThreads << " threads.";
+        G4Exception("StartupReport::Notify", "PhonMain001", JustWarning, msg);
+      }
+#endif
+      return true;
+    }
+
+  private:
+    std::chrono::steady_clock::time_point start;
+    G4int requestedThreads;	// From -t (0 = not given)
+    G4bool done;
+  };
+}
+
 int main(int argc,char** argv)
 {
+ // Parse command line
+ //
+ G4bool headless = false;
+ G4int nThreads = 0;
+ long seed = 0;
+ G4int nEvents = 0;
+ G4String outputDir;
+ G4String macroFile;
+
+ for (G4int i=1; i<argc; i++) {
+   G4String arg = argv[i];
+   G4bool hasValue = (i+1 < argc);
+
+   if (arg == "--headless") headless = true;
+   else if ((arg == "-t" || arg == "--threads") && hasValue) nThreads = std::atoi(argv[++i]);
+   else if ((arg == "-s" || arg == "--seed") && hasValue) seed = std::atol(argv[++i]);
+   else if ((arg == "-n" || arg == "--events") && hasValue) nEvents = std::atoi(argv[++i]);
+   else if ((arg == "-o" || arg == "--output") && hasValue) outputDir = argv[++i];
+   else if (arg == "-h" || arg == "--help") { PrintUsage(argv[0]); return 0; }
+   else if (arg[0] != '-' && macroFile.empty()) macroFile = arg;
+   else { PrintUsage(argv[0]); return 1; }
+ }
+
+ G4bool interactive = !headless && macroFile.empty() && nEvents <= 0;
+ StartupReport startup(nThreads);
+
+ if (seed > 0) G4Random::setTheSeed(seed);
 
  // Construct the run manager
 #ifdef G4MULTITHREADED
     auto runManager = new G4MTRunManager;
-    G4int nThreads = G4Threading::G4GetNumberOfCores();
+    if (nThreads <= 0) nThreads = G4Threading::G4GetNumberOfCores();
     runManager->SetNumberOfThreads(nThreads);
     G4cout << "----> G4CMP Phonon example is running in multithreaded mode with " << nThreads << " threads." << G4endl;
 #else
@@ -46,16 +137,29 @@ int main(int argc,char** argv)
  G4CMPConfigManager::Instance();
  PhononConfigManager::Instance();
 
- // Visualization manager
+ if (!outputDir.empty()) {
+   if (mkdir(outputDir.c_str(), 0755) != 0 && errno != EEXIST) {
+     G4cerr << "Cannot create output directory " << outputDir << ": "
+            << std::strerror(errno) << G4endl;
+     delete runManager;
+     return 1;
+   }
+   PhononConfigManager::SetOutputDirectory(outputDir);
+ }
+
+ // Visualization manager (skipped entirely in headless mode)
  //
- G4VisManager* visManager = new G4VisExecutive;
- visManager->Initialize();
- 
+ G4VisManager* visManager = 0;
+ if (!headless) {
+   visManager = new G4VisExecutive;
+   visManager->Initialize();
+ }
+
  // Get the pointer to the User Interface manager
  //
  G4UImanager* UImanager = G4UImanager::GetUIpointer();  
 
- if (argc==1)   // Define UI session for interactive mode
+ if (interactive)   // Define UI session for interactive mode
  {
       G4UIExecutive * ui = new G4UIExecutive(argc,argv);
       ui->SessionStart();
@@ -63,9 +167,16 @@ int main(int argc,char** argv)
  }
  else           // Batch mode
  {
-   G4String command = "/control/execute ";
-   G4String fileName = argv[1];
-   UImanager->ApplyCommand(command+fileName);
+   if (!macroFile.empty()) {
+     G4String command = "/control/execute ";
+     UImanager->ApplyCommand(command+macroFile);
+   }
+
+   if (nEvents > 0) {
+     if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_PreInit)
+       UImanager->ApplyCommand("/run/initialize");
+     UImanager->ApplyCommand("/run/beamOn " + std::to_string(nEvents));
+   }
  }
 
  delete visManager;
@@ -73,5 +184,3 @@ int main(int argc,char** argv)
 
  return 0;
 }
-
-
@@ -0,0 +1,56 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononAccumulable_hh
+#define PhononAccumulable_hh 1
+
+// $Id$
+// File:  PhononAccumulable.hh
+//
+// Description:	Common interface of the run-level tallies and counters
+//		owned by PhononRunAction.  Each thread has its own copy,
+//		registered with G4AccumulableManager, which calls Merge()
+//		on master to add in every worker and Reset() before each
+//		run.  PhononRunAction drives the rest of the cycle for all
+//		of them alike:
+//		  Configure()  start of run, every thread: read settings
+//		               from PhononConfigManager
+//		  IsActive()   whether the settings enabled it
+//		  EndOfRun()   master only, after merging and only if
+//		               active: write output and print a summary
+//
+//		Derived classes implement Add() for one worker's copy of
+//		their own type; Merge() does the downcast.
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+#include <iosfwd>
+
+
+class PhononAccumulable : public G4VAccumulable {
+public:
+  PhononAccumulable(const G4String& name) : G4VAccumulable(name) {;}
+  virtual ~PhononAccumulable() {;}
+
+  virtual void Configure() = 0;
+  virtual G4bool IsActive() const = 0;
+  virtual void EndOfRun(G4int runID, std::ostream& os) const = 0;
+};
+
+
+// Downcast in one place; every thread holds the same derived type
+
+template <class T>
+class PhononAccumulableT : public PhononAccumulable {
+public:
+  PhononAccumulableT(const G4String& name) : PhononAccumulable(name) {;}
+  virtual ~PhononAccumulableT() {;}
+
+  virtual void Merge(const G4VAccumulable& other) {
+    static_cast<T*>(this)->Add(static_cast<const T&>(other));
+  }
+};
+
+#endif	/* PhononAccumulable_hh */
@@ -14,6 +14,7 @@ class PhononActionInitialization : public G4VUserActionInitialization {
 public:
   PhononActionInitialization() {;}
   virtual ~PhononActionInitialization() {;}
+  virtual void BuildForMaster() const;
   virtual void Build() const;
 };
 
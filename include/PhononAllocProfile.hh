@@ -0,0 +1,118 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononAllocProfile_hh
+#define PhononAllocProfile_hh 1
+
+// $Id$
+// File:  PhononAllocProfile.hh
+//
+// Description:	Opt-in heap and memory-footprint profile for the phonon
+//		example.  With the CMake option G4CMP_PHONON_ALLOC_HOOKS,
+//		the executable replaces the global operator new and delete
+//		(see PhononAllocHooks.cc); when profiling is enabled they
+//		count allocations and bytes into a block owned by the
+//		calling thread, split by the event phase that thread is in.
+//		Both sides count the allocator's usable size of the block,
+//		so that allocated and freed bytes balance.  Without the
+//		option, only the per-event track and RSS figures are kept.
+//		Phases are set by the user actions.  At end of each event
+//		the thread also records the bytes allocated in the event,
+//		its peak number of live tracks, and the process RSS.
+//
+//		Objects from G4Allocator pools (tracks, steps, dynamic
+//		particles) are only counted when a pool page is allocated.
+//
+//		Blocks are registered like PhononRunProgress counters, and
+//		read by the master at end of run, after workers have
+//		finished, so they need no atomics.
+
+#include "globals.hh"
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+
+
+class PhononAllocProfile {
+public:
+  enum Phase { kOther, kGeneration, kTracking, kEndOfEvent, kOutput,
+	       kNPhases };
+
+  struct Counters {
+    uint64_t allocs[kNPhases] = {};
+    uint64_t bytes[kNPhases] = {};
+    uint64_t freedBytes[kNPhases] = {};
+
+    uint64_t eventBytes = 0;		// Allocated in current event
+    G4int eventPeakTracks = 0;		// Peak live tracks in current event
+
+    G4long events = 0;
+    uint64_t maxEventBytes = 0;
+    G4int maxEventTracks = 0;
+    G4double sumEventTracks = 0.;	// For mean of per-event peaks
+    G4double maxRSS = 0.;		// Largest end-of-event RSS sample
+  };
+
+  static PhononAllocProfile* Instance();
+  static G4bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+  // Master: reset all blocks and switch counting on or off for the run
+  void BeginRun(G4bool enable);
+
+  // Every thread: attach this thread's block (created on first call)
+  void RegisterThread();
+
+  // Phase of calling thread, and a guard to restore it
+  static void SetPhase(Phase phase) { threadPhase = phase; }
+  class Scope {
+  public:
+    Scope(Phase phase) : previous(threadPhase) { threadPhase = phase; }
+    ~Scope() { threadPhase = previous; }
+  private:
+    Phase previous;
+  };
+
+  // Per-event footprint, from tracking and event actions
+  static void NoteLiveTracks(G4int nTracks);
+  static void EndEvent();
+
+  // Per-thread and per-phase summary (master, after run)
+  void Report(std::ostream& os) const;
+
+  // Called only from the replacement operator new and delete
+  static void NoteHooksInstalled() { hooksInstalled = true; }
+  static void CountAlloc(size_t size) {
+    if (Counters* c = threadCounters) {
+      c->allocs[threadPhase]++;
+      c->bytes[threadPhase] += size;
+      c->eventBytes += size;
+    }
+  }
+
+  static void CountFree(size_t size) {
+    if (Counters* c = threadCounters) {
+      c->freedBytes[threadPhase] += size;
+    }
+  }
+
+private:
+  PhononAllocProfile() {;}
+  PhononAllocProfile(const PhononAllocProfile&) = delete;
+  PhononAllocProfile& operator=(const PhononAllocProfile&) = delete;
+
+  static PhononAllocProfile* theInstance;
+  static std::atomic<G4bool> enabled;
+  static G4bool hooksInstalled;		// Set during static initialization
+  static thread_local Counters* threadCounters;
+  static thread_local Phase threadPhase;
+
+  mutable std::mutex countersMutex;	// Guards map, not counter values
+  std::map<G4int, std::unique_ptr<Counters> > counters;
+};
+
+#endif	/* PhononAllocProfile_hh */
@@ -0,0 +1,51 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononBatchMonitor_hh
+#define PhononBatchMonitor_hh 1
+
+// $Id$
+// File:  PhononBatchMonitor.hh
+//
+// Description:	Per-thread feed for adaptive run length.  Sums the
+//		absorbed KID energy and arrival-time moment of each event,
+//		adds them with the injected energy into the current batch,
+//		and hands every full batch to PhononRunLength.  A partial
+//		batch at end of run is dropped, as batch means assume equal
+//		batch sizes; its events are counted by the controller.
+
+#include "PhononRunLength.hh"
+#include "globals.hh"
+
+
+class PhononBatchMonitor {
+public:
+  PhononBatchMonitor();
+
+  // Batch size from PhononConfigManager; inactive unless the controller
+  // has a target (master sets that up before workers start)
+  void Configure();
+  G4bool IsActive() const { return active; }
+
+  // Absorption in named volume (weight included), during current event
+  void Score(const G4String& volume, G4double energy, G4double time);
+
+  // Returns true once the controller has asked for the run to stop
+  G4bool EndEvent(G4double injectedEnergy);
+
+  // Report the incomplete batch, if any, as discarded
+  void EndOfRun();
+
+private:
+  G4bool active;
+  G4int batchSize;
+  PhononRunLength::Sums batch;
+
+  G4double kidEnergy;		// Sums for event in progress
+  G4double kidEnergyWindow;
+  G4double kidTime;
+};
+
+#endif	/* PhononBatchMonitor_hh */
@@ -15,8 +15,16 @@
 //		changed via macro commands (see PhononConfigMessenger).
 //
 // 20170816  M. Kelsey -- Extract hit filename from G4CMPConfigManager.
+// 20261019  Add settings for output files, directory and {run}/{thread}
+//		templates, progress reporting, energy and scan tallies,
+//		timing and heap profiling, importance splitting, film
+//		response, macro-phonon merging, adaptive run length,
+//		boundary histories and tracing.  Remove unused
+//		UpdateGeometry(); no setting here changes geometry.
 
 #include "globals.hh"
+#include "G4ThreeVector.hh"
+#include <vector>
 
 class PhononConfigMessenger;
 
@@ -28,12 +36,107 @@ public:
 
   // Access current values
   static const G4String& GetHitOutput()  { return Instance()->Hit_file; }
+  static const G4String& GetTrackingOutput() { return Instance()->Track_file; }
+  static const G4String& GetOutputFormat() { return Instance()->outputFormat; }
+  static const G4String& GetOutputDirectory() { return Instance()->outputDir; }
+  static const G4String& GetEnergyTallyFile() { return Instance()->tallyFile; }
+  static const std::vector<G4int>& GetEnergyTallyBins() { return Instance()->tallyBins; }
+  static G4double GetEnergyTallyTime() { return Instance()->tallyTime; }
+  static G4int GetEnergyTallyMaxVoxels() { return Instance()->tallyMaxVoxels; }
+  static G4bool GetProcessTiming() { return Instance()->processTiming; }
+  static G4bool GetAllocationProfile() { return Instance()->allocProfile; }
+  static const G4String& GetHistoryFile() { return Instance()->historyFile; }
+  static const std::vector<G4double>& GetImportanceShells() { return Instance()->importanceShells; }
+  static G4int GetSplittingFactor() { return Instance()->splittingFactor; }
+  static const G4String& GetFilmResponse() { return Instance()->filmResponse; }
+  static G4int GetFilmTableSamples() { return Instance()->filmTableSamples; }
+  static G4int GetMergeMaxTracks() { return Instance()->mergeMaxTracks; }
+  static G4double GetMergeTolerance() { return Instance()->mergeTolerance; }
+  static G4double GetMergeDistance() { return Instance()->mergeDistance; }
+  static const G4String& GetScanFile() { return Instance()->scanFile; }
+  static G4double GetScanSpotRadius() { return Instance()->scanSpotRadius; }
+  static G4int GetScanPoints()
+    { return Instance()->scanBins[0] * Instance()->scanBins[1]; }
+
+  // Position (x,y) of scan point; grid is nx by ny nodes spanning the
+  // scan range, with x varying fastest
+  static G4ThreeVector GetScanPosition(G4int point);
+  static G4double GetTargetPrecision() { return Instance()->targetPrecision; }
+  static const std::vector<G4String>& GetPrecisionEstimators() { return Instance()->precisionEstimators; }
+  static G4int GetBatchSize() { return Instance()->batchSize; }
+  static G4int GetTraceRate() { return Instance()->traceRate; }
+  static const G4String& GetTraceMode() { return Instance()->traceMode; }
+  static const G4String& GetTraceFile() { return Instance()->traceFile; }
+  static G4int GetTraceBuffer() { return Instance()->traceBuffer; }
+  static G4double GetHeartbeatInterval() { return Instance()->heartbeatInterval; }
+  static const G4String& GetStatusFile() { return Instance()->statusFile; }
+
+  // Expand "{run}" and "{thread}" in output filename template, and put
+  // relative names in the output directory; worker sinks are reopened
+  // with the result at each BeginOfRunAction.  On workers (thread ID 0
+  // and up) a template without "{thread}" is made unique per thread.
+  static G4String GetOutputName(const G4String& pattern, G4int runID);
+  static G4String GetOutputName(const G4String& pattern, G4int runID,
+				G4int threadID);
 
   // Change values (e.g., via Messenger)
+  // NOTE: Output sinks are not geometry, and must not trigger a rebuild
   static void SetHitOutput(const G4String& name)
-    { Instance()->Hit_file=name; UpdateGeometry(); }
-
-  static void UpdateGeometry();
+    { Instance()->Hit_file=name; }
+  static void SetTrackingOutput(const G4String& name)
+    { Instance()->Track_file=name; }
+  static void SetOutputFormat(const G4String& format)
+    { Instance()->outputFormat=format; }
+  static void SetOutputDirectory(const G4String& dir)
+    { Instance()->outputDir=dir; }
+  static void SetEnergyTallyFile(const G4String& name)
+    { Instance()->tallyFile=name; }
+  static void SetEnergyTallyBins(G4int nx, G4int ny, G4int nz, G4int nt)
+    { Instance()->tallyBins = { nx, ny, nz, nt }; }
+  static void SetEnergyTallyTime(G4double val)
+    { Instance()->tallyTime=val; }
+  static void SetEnergyTallyMaxVoxels(G4int val)
+    { Instance()->tallyMaxVoxels=val; }
+  static void SetProcessTiming(G4bool val) { Instance()->processTiming=val; }
+  static void SetAllocationProfile(G4bool val) { Instance()->allocProfile=val; }
+  static void SetHistoryFile(const G4String& name)
+    { Instance()->historyFile=name; }
+  static void SetImportanceShells(const std::vector<G4double>& radii)
+    { Instance()->importanceShells=radii; }
+  static void SetSplittingFactor(G4int val) { Instance()->splittingFactor=val; }
+  static void SetFilmResponse(const G4String& model)
+    { Instance()->filmResponse=model; }
+  static void SetFilmTableSamples(G4int val)
+    { Instance()->filmTableSamples=val; }
+  static void SetMergeMaxTracks(G4int val) { Instance()->mergeMaxTracks=val; }
+  static void SetMergeTolerance(G4double val)
+    { Instance()->mergeTolerance=val; }
+  static void SetMergeDistance(G4double val)
+    { Instance()->mergeDistance=val; }
+  static void SetScanGrid(G4int nx, G4int ny)
+    { Instance()->scanBins = { nx, ny }; }
+  static void SetScanRange(G4double xmin, G4double xmax,
+			   G4double ymin, G4double ymax)
+    { Instance()->scanRange = { xmin, xmax, ymin, ymax }; }
+  static void SetScanSpotRadius(G4double val)
+    { Instance()->scanSpotRadius=val; }
+  static void SetScanFile(const G4String& name)
+    { Instance()->scanFile=name; }
+  static void SetTargetPrecision(G4double val)
+    { Instance()->targetPrecision=val; }
+  static void SetPrecisionEstimators(const std::vector<G4String>& names)
+    { Instance()->precisionEstimators=names; }
+  static void SetBatchSize(G4int val) { Instance()->batchSize=val; }
+  static void SetTraceRate(G4int val) { Instance()->traceRate=val; }
+  static void SetTraceMode(const G4String& mode)
+    { Instance()->traceMode=mode; }
+  static void SetTraceFile(const G4String& name)
+    { Instance()->traceFile=name; }
+  static void SetTraceBuffer(G4int val) { Instance()->traceBuffer=val; }
+  static void SetHeartbeatInterval(G4double val)
+    { Instance()->heartbeatInterval=val; }
+  static void SetStatusFile(const G4String& name)
+    { Instance()->statusFile=name; }
 
 private:
   PhononConfigManager();		// Singleton: only constructed on request
@@ -46,6 +149,36 @@ private:
 
 private:
   G4String Hit_file;	// Output file of e/h hits ($G4CMP_HIT_FILE)
+  G4String Track_file;	// Output of phonon steps ($G4CMP_TRACKING_FILE)
+  G4String outputFormat;	// Text output delimiter: "csv", "tsv" or "none"
+  G4String outputDir;	// Directory for output files ($G4CMP_OUTPUT_DIR)
+  G4String tallyFile;	// Energy-density tally output (empty = disabled)
+  std::vector<G4int> tallyBins;	// Tally bins in x, y, z and time
+  G4double tallyTime;	// Upper edge of tally time window
+  G4int tallyMaxVoxels;	// Cap on stored (non-empty) voxels per thread
+  G4bool processTiming;	// Wrap phonon processes with timers
+  G4bool allocProfile;	// Count heap use per thread and event phase
+  G4String historyFile;	// Per-thread boundary histories (empty = off)
+  std::vector<G4double> importanceShells;  // Radii around KID (empty = off)
+  G4int splittingFactor;	// Importance ratio between adjacent shells
+  G4String filmResponse;	// Al sensor model: perfect, kaplan or tabulated
+  G4int filmTableSamples;	// KaplanQP samples per tabulated energy
+  G4int mergeMaxTracks;	// Downconversion generation cap (0 = no merging)
+  G4double mergeTolerance;	// Relative energy/direction cell width
+  G4double mergeDistance;	// Position cell width for merging
+  std::vector<G4int> scanBins;	// Injection grid nx, ny (0 = no scan)
+  std::vector<G4double> scanRange;	// Grid xmin, xmax, ymin, ymax
+  G4double scanSpotRadius;	// Injection disc radius about each point
+  G4String scanFile;	// Per-point response output
+  G4double targetPrecision;	// Relative uncertainty to stop run (0 = off)
+  std::vector<G4String> precisionEstimators;	// kid, eta and/or tau
+  G4int batchSize;	// Events per batch for batch-means errors
+  G4int traceRate;	// Trace 1 in N tracks or events (0 = off)
+  G4String traceMode;	// Sample "track" or "event"
+  G4String traceFile;	// Per-thread trajectory output
+  G4int traceBuffer;	// Maximum traced steps held per event
+  G4double heartbeatInterval;	// Time between progress reports (0 = off)
+  G4String statusFile;	// Progress snapshot file ($G4CMP_STATUS_FILE)
 
   PhononConfigMessenger* messenger;
 };
@@ -13,11 +13,21 @@
 //		PhononConfigManager.
 //
 // 20170816  Michael Kelsey
+// 20261019  Add commands for output files and format, progress reporting,
+//		energy and scan tallies, timing and heap profiling,
+//		importance splitting, film response, macro-phonon merging,
+//		adaptive run length, boundary histories and tracing;
+//		group SetNewValue() by topic.
 
 #include "G4UImessenger.hh"
 
 class PhononConfigManager;
 class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+class G4UIcmdWithoutParameter;
 class G4UIcommand;
 
 
@@ -28,9 +38,45 @@ public:
 
   void SetNewValue(G4UIcommand* cmd, G4String value);
 
+private:
+  G4bool SetOutputValue(G4UIcommand* cmd, const G4String& value);
+  G4bool SetTallyValue(G4UIcommand* cmd, const G4String& value);
+  G4bool SetBiasingValue(G4UIcommand* cmd, const G4String& value);
+  G4bool SetRunValue(G4UIcommand* cmd, const G4String& value);
+
 private:
   PhononConfigManager* theManager;
   G4UIcmdWithAString* hitsCmd;
+  G4UIcmdWithAString* trackCmd;
+  G4UIcmdWithAString* formatCmd;
+  G4UIcmdWithAString* tallyFileCmd;
+  G4UIcommand* tallyBinsCmd;
+  G4UIcmdWithADoubleAndUnit* tallyTimeCmd;
+  G4UIcmdWithAnInteger* tallyMaxCmd;
+  G4UIcmdWithABool* timingCmd;
+  G4UIcmdWithABool* allocCmd;
+  G4UIcmdWithAString* historyCmd;
+  G4UIcmdWithAString* shellsCmd;
+  G4UIcmdWithAnInteger* splitCmd;
+  G4UIcmdWithAString* filmCmd;
+  G4UIcmdWithAnInteger* filmSamplesCmd;
+  G4UIcmdWithAnInteger* mergeMaxCmd;
+  G4UIcmdWithADouble* mergeTolCmd;
+  G4UIcmdWithADoubleAndUnit* mergeDistCmd;
+  G4UIcommand* scanGridCmd;
+  G4UIcommand* scanRangeCmd;
+  G4UIcmdWithADoubleAndUnit* scanSpotCmd;
+  G4UIcmdWithAString* scanFileCmd;
+  G4UIcmdWithADouble* precisionCmd;
+  G4UIcmdWithAString* estimatorsCmd;
+  G4UIcmdWithAnInteger* batchCmd;
+  G4UIcmdWithAnInteger* traceRateCmd;
+  G4UIcmdWithAString* traceModeCmd;
+  G4UIcmdWithAString* traceFileCmd;
+  G4UIcmdWithAnInteger* traceBufferCmd;
+  G4UIcmdWithADoubleAndUnit* heartbeatCmd;
+  G4UIcmdWithAString* statusCmd;
+  G4UIcmdWithoutParameter* progressCmd;
 
 private:
   PhononConfigMessenger(const PhononConfigMessenger&);	// Copying is forbidden
@@ -10,6 +10,8 @@
 //
 // 20221006  M. Kelsey -- Remove "IsField" flag, unnecessary with phonons.
 //		Add material properties for aluminum phonon sensors
+// 20261019  Attach PhononSensitivity to substrate per worker thread.
+// 20261019  Attach sensor film model to siAl unless FilmResponse is perfect.
 
 #ifndef PhononDetectorConstruction_h
 #define PhononDetectorConstruction_h 1
@@ -29,6 +31,7 @@ public:
   
 public:
   virtual G4VPhysicalVolume* Construct();
+  virtual void ConstructSDandField();
   
 private:
   void DefineMaterials();
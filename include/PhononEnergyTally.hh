@@ -0,0 +1,89 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononEnergyTally_hh
+#define PhononEnergyTally_hh 1
+
+// $Id$
+// File:  PhononEnergyTally.hh
+//
+// Description:	Time-resolved 3D voxel tally of phonon energy in the
+//		substrate.  Each step scores (energy x weight x time spent)
+//		into (x,y,z,t) bins, sampling long ballistic steps at the
+//		voxel pitch.  Dividing a bin by its time width gives the
+//		mean phonon energy held in that voxel during the interval.
+//
+//		Storage is a sparse per-thread map, capped at a fixed number
+//		of voxels so memory does not grow with track count; scores
+//		which cannot be stored (outside the mesh or time window, or
+//		beyond the cap) are summed as overflow.  Worker tallies are
+//		merged into the master via G4AccumulableManager, through the
+//		same cap; voxels dropped there are counted and reported.
+//
+//		Binary output layout (little-endian, native sizes):
+//		  char[8]   "PHTALLY1"
+//		  int32[4]  nx, ny, nz, nt
+//		  double[7] xmin, xmax, ymin, ymax, zmin, zmax [mm], tmax [ns]
+//		  double    overflow [eV*ns]
+//		  uint64    number of entries
+//		  entries:  uint64 index, double score [eV*ns]
+//		with index = ((it*nz + iz)*ny + iy)*nx + ix.
+
+#include "PhononAccumulable.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+#include <cstdint>
+#include <unordered_map>
+
+class G4Step;
+class G4VPhysicalVolume;
+
+
+class PhononEnergyTally : public PhononAccumulableT<PhononEnergyTally> {
+public:
+  PhononEnergyTally(const G4String& volumeName,
+		    const G4String& name="PhononEnergyTally");
+  virtual ~PhononEnergyTally() {;}
+
+  // Set binning from PhononConfigManager and substrate extent; inactive
+  // if the volume is not found or the tally has no output file
+  virtual void Configure();
+  virtual G4bool IsActive() const { return volume != 0; }
+
+  void Score(const G4Step* step);
+
+  void Add(const PhononEnergyTally& other);
+  virtual void Reset();
+
+  // Write merged tally to the configured file and print a summary
+  virtual void EndOfRun(G4int runID, std::ostream& os) const;
+
+  // Write merged tally (master only); returns false on I/O error
+  G4bool Write(const G4String& fileName) const;
+
+  size_t GetNumberOfVoxels() const { return voxels.size(); }
+  G4double GetTotal() const { return total; }
+  G4double GetOverflow() const { return overflow; }
+
+private:
+  void Add(const G4ThreeVector& pos, G4double time, G4double score);
+  G4bool Add(uint64_t index, G4double score);	// False if over the cap
+
+  G4String volumeName;
+  const G4VPhysicalVolume* volume;	// Scoring volume (shared geometry)
+  G4int nBins[4];			// x, y, z, t
+  G4ThreeVector lower, upper;		// Global extent of scoring volume
+  G4ThreeVector pitch;			// Voxel size along each axis
+  G4double tMax;
+  G4double minPitch;			// Sampling length for long steps
+  size_t maxVoxels;
+
+  std::unordered_map<uint64_t, G4double> voxels;
+  G4double total;
+  G4double overflow;
+  size_t mergeDropped;			// Worker voxels over the cap on master
+};
+
+#endif	/* PhononEnergyTally_hh */
@@ -0,0 +1,44 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononEventAction_hh
+#define PhononEventAction_hh 1
+
+// $Id$
+// File:  PhononEventAction.hh
+//
+// Description:	Event action for G4CMP phonon example.  Publishes the
+//		number of completed events on this worker to the shared
+//		progress counters, closes each event in the run action's
+//		injection scan tally and run length batch, writes traced
+//		trajectories, and soft-aborts the run once the run length
+//		target has been reached.
+
+#include "G4UserEventAction.hh"
+#include "PhononRunProgress.hh"
+
+class G4Event;
+class PhononRunAction;
+class PhononBatchMonitor;
+class PhononScanTally;
+class PhononTrajectoryTracer;
+
+
+class PhononEventAction : public G4UserEventAction {
+public:
+  PhononEventAction(PhononRunAction* run=0);
+  virtual ~PhononEventAction();
+
+  virtual void BeginOfEventAction(const G4Event* event);
+  virtual void EndOfEventAction(const G4Event* event);
+
+private:
+  PhononRunProgress::Counters* progress;	// Owned by PhononRunProgress
+  PhononScanTally* scanTally;			// Owned by PhononRunAction
+  PhononBatchMonitor* batchMonitor;		// Owned by PhononRunAction
+  PhononTrajectoryTracer* tracer;		// Owned by PhononRunAction
+};
+
+#endif	/* PhononEventAction_hh */
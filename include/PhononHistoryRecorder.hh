@@ -0,0 +1,118 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononHistoryRecorder_hh
+#define PhononHistoryRecorder_hh 1
+
+// $Id$
+// File:  PhononHistoryRecorder.hh
+//
+// Description:	Wrapper around the phonon boundary process which records
+//		the sequence of surface interactions of every track, so
+//		that surface probabilities can be changed offline by
+//		reweighting (see reweight_surfaces.C) instead of rerunning.
+//		Installed by PhononPhysicsList when /g4cmp/HistoryFile is
+//		set before initialization.  Each thread writes its own file;
+//		PhononConfigManager::GetOutputName() makes worker names
+//		unique even without "{thread}", as records from two threads
+//		in one file could not be read back.
+//
+//		Each boundary step is classified from the process result:
+//		  killed         absorbed or transmitted; both end the
+//		                 track with its energy in the next volume
+//		  specular       reflected with the tangential wavevector
+//		                 kept
+//		  diffuse        reflected otherwise
+//		  downconverted  anharmonic decay at the surface: killed,
+//		                 with two phonon secondaries carrying all
+//		                 of its energy and nothing deposited
+//		  bounce limit   killed without a deposit by G4CMP's
+//		                 maximum phonon bounce count instead of
+//		                 a sampled reflection
+//
+//		With each interaction the probabilities G4CMP sampled from
+//		are written: the surface absorption and reflection
+//		probabilities, and the anharmonic, specular and diffuse
+//		reflection probabilities of the G4CMPSurfaceProperty
+//		scattering coefficients at the phonon frequency E/h,
+//		normalized to one as G4CMPPhononBoundaryProcess does.
+//		Reweighting can only move weight between outcomes which had
+//		nonzero probability when recorded.
+//
+//		Binary layout (host byte order), after an 8-byte "PHNHIST2":
+//		  'S' u16 surface, u8 n, char[n] border name, u8 m,
+//		      char[m] property name
+//		  'T' i32 event, i32 track, i32 parent, f32 start weight,
+//		      f32 final weight, f32 start time [ns], f32 start energy
+//		      [eV], u32 count, then count x { u16 surface, u8 outcome,
+//		      f32 energy [eV], f32 time [ns], f32 abs, refl, anh,
+//		      spec, diff }
+//		Parents are always written before their secondaries.
+
+#include "G4WrapperProcess.hh"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <vector>
+
+class G4CMPLogicalBorderSurface;
+class G4VParticleChange;
+
+
+class PhononHistoryRecorder : public G4WrapperProcess {
+public:
+  enum Outcome { kKilled, kSpecular, kDiffuse, kDownconverted, kBounceLimit };
+
+  PhononHistoryRecorder(G4VProcess* process);
+  virtual ~PhononHistoryRecorder();
+
+  virtual G4VParticleChange* PostStepDoIt(const G4Track& track,
+					  const G4Step& step);
+
+  // Reopen output (called by PhononRunAction at start of each run);
+  // nothing is done if the name is unchanged, empty name stops output
+  void SetOutputFile(const G4String& fileName);
+  void Flush();
+
+  // Bracket each track (called by PhononTrackingAction)
+  void BeginTrack(const G4Track* track);
+  void EndTrack(const G4Track* track);
+
+  // Recorder built on the calling thread, or null if not installed
+  static PhononHistoryRecorder* GetThreadRecorder();
+
+private:
+  struct Interaction {
+    uint16_t surface;
+    uint8_t outcome;
+    float energy;		// eV
+    float time;			// ns
+    float prob[5];		// abs, refl, anh, spec, diff as sampled
+  };
+
+  uint16_t GetSurfaceID(const G4CMPLogicalBorderSurface* border);
+  void GetProbabilities(const G4CMPLogicalBorderSurface* border,
+			G4double energy, float prob[5]) const;
+  static G4bool IsDownconversion(const G4VParticleChange* change,
+				 G4double energy);
+
+  template <class T> void Put(const T& value) {
+    fout.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  std::ofstream fout;
+  G4String fileName;
+  std::map<const G4CMPLogicalBorderSurface*, uint16_t> surfaceIDs;
+
+  G4int eventID;			// Track in progress
+  G4int trackID;
+  G4int parentID;
+  G4double startWeight;
+  G4double startTime;
+  G4double startEnergy;
+  std::vector<Interaction> interactions;
+};
+
+#endif	/* PhononHistoryRecorder_hh */
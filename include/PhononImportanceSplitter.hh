@@ -0,0 +1,83 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononImportanceSplitter_hh
+#define PhononImportanceSplitter_hh 1
+
+// $Id$
+// File:  PhononImportanceSplitter.hh
+//
+// Description:	Geometric importance splitting of phonons toward the KID.
+//		The substrate is divided into nested shells by lateral (x,y)
+//		distance from the KID footprint; shell k has importance
+//		factor^k.  After each step in the substrate, a phonon moving
+//		to higher importance is split into weighted copies, and one
+//		moving to lower importance plays Russian roulette.  Weights
+//		are carried on the track, and so reach PhononSensitivity's
+//		weight column and every weighted tally.
+//
+//		The decisions are applied by PhononSplittingProcess through
+//		its particle change; copies are new phonons from
+//		G4CMP::CreatePhonon, with the parent's mode, energy and
+//		wavevector, and so fresh G4CMPPhononTrackInfo.  The splitter
+//		of each thread is found through GetThreadSplitter().
+//
+//		Counters are merged on master via G4AccumulableManager.
+
+#include "PhononAccumulable.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+#include <iosfwd>
+#include <vector>
+
+class G4ParticleChange;
+class G4Step;
+class G4VPhysicalVolume;
+
+
+class PhononImportanceSplitter
+  : public PhononAccumulableT<PhononImportanceSplitter> {
+public:
+  PhononImportanceSplitter(const G4String& substrateName,
+			   const G4String& sensorName,
+			   const G4String& name="PhononImportanceSplitter");
+  virtual ~PhononImportanceSplitter();
+
+  // Read shells from PhononConfigManager and locate the KID; inactive if
+  // no shells are defined or either volume is missing
+  virtual void Configure();
+  virtual G4bool IsActive() const { return substrate != 0; }
+
+  // Split or roulette track at end of step, proposing new weight or
+  // kill and adding copies as secondaries to an initialized change
+  void Apply(const G4Step& step, G4ParticleChange& change);
+
+  // Splitter built on the calling thread (by its PhononRunAction)
+  static PhononImportanceSplitter* GetThreadSplitter();
+
+  void Add(const PhononImportanceSplitter& other);
+  virtual void Reset();
+
+  virtual void EndOfRun(G4int runID, std::ostream& os) const;
+
+private:
+  G4int GetShell(const G4ThreeVector& pos) const;
+
+  G4String substrateName;
+  G4String sensorName;
+
+  const G4VPhysicalVolume* substrate;
+  G4ThreeVector sensorCenter;	// Global position of KID
+  G4double sensorHalfX, sensorHalfY;
+  std::vector<G4double> radii;	// Shell radii, largest first
+  G4int factor;
+
+  G4long nSplit;		// Tracks split
+  G4long nCopies;		// Copies created
+  G4long nRouletteKilled;
+  G4long nRouletteSurvived;
+};
+
+#endif	/* PhononImportanceSplitter_hh */
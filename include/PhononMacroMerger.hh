@@ -0,0 +1,94 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononMacroMerger_hh
+#define PhononMacroMerger_hh 1
+
+// $Id$
+// File:  PhononMacroMerger.hh
+//
+// Description:	Combines downconversion secondaries into weighted macro-
+//		phonons, to bound the track population of anharmonic
+//		cascades.  Once an event exceeds the track cap,
+//		PhononStackingAction holds each generation of secondaries
+//		in the waiting stack and hands it here when the urgent
+//		stack empties.  If the generation exceeds the track cap,
+//		phonons are grouped into cells of polarization, log
+//		energy, position and direction; the cells are doubled in
+//		size until the cap is met, up to a fixed limit.  A
+//		generation still over the cap at that limit is merged as
+//		far as it goes, and counted; the first in each run raises
+//		a warning.
+//
+//		Each cell is replaced by one new phonon, made with
+//		G4CMP::CreatePhonon so that its track info and velocity
+//		are consistent, with weight W = sum(w_i) and energy
+//		E = sum(w_i*E_i)/W, which conserves energy exactly.  It
+//		takes the mode, wavevector, position, time and parentage of
+//		the member with the largest weighted energy.  The originals
+//		are killed.  The spread of energy, position and
+//		direction folded into each macro-phonon is accumulated as
+//		the merging error, merged on master and reported at end of
+//		run.
+
+#include "PhononAccumulable.hh"
+#include "globals.hh"
+#include <iosfwd>
+#include <unordered_set>
+#include <vector>
+
+class G4Track;
+
+
+class PhononMacroMerger : public PhononAccumulableT<PhononMacroMerger> {
+public:
+  PhononMacroMerger(const G4String& name="PhononMacroMerger");
+  virtual ~PhononMacroMerger() {;}
+
+  // Read cap and tolerances from PhononConfigManager; inactive if cap is 0
+  virtual void Configure();
+  virtual G4bool IsActive() const { return maxTracks > 0; }
+
+  // Phonon produced by anharmonic downconversion
+  G4bool IsCandidate(const G4Track* track) const;
+
+  // Track population above which candidates are held for merging
+  size_t GetMaxTracks() const { return maxTracks; }
+
+  // Merge one generation of stacked tracks: merged tracks are added to
+  // discard, and their replacements to macros, for the caller to stack.
+  // Returns false if nothing merged.
+  G4bool MergeStage(const std::vector<const G4Track*>& stage,
+		    std::unordered_set<const G4Track*>& discard,
+		    std::vector<G4Track*>& macros);
+
+  void Add(const PhononMacroMerger& other);
+  virtual void Reset();
+
+  // Summary, if any generation needed merging
+  virtual void EndOfRun(G4int runID, std::ostream& os) const;
+
+private:
+  G4Track* MergeCell(const std::vector<const G4Track*>& cell,
+		     std::unordered_set<const G4Track*>& discard);
+
+  size_t maxTracks;
+  G4double tolerance;		// Relative energy and direction cell width
+  G4double distance;		// Position cell width
+
+  G4long nStages;		// Generations which needed merging
+  G4long nCoarsened;		// ... and cell growth to meet the cap
+  G4long nOverCap;		// ... and still exceeded it at largest cells
+  G4double maxScale;		// Largest cell growth factor applied
+  G4long nMerged;		// Phonons folded into another
+  G4long nMacro;		// Macro-phonons produced
+  G4double energy;		// Weighted energy of merged cells
+  G4double energySpread;	// Sum of w*|E-E_macro|
+  G4double displacement;	// Sum of w*E*|x-x_macro|
+  G4double angle;		// Sum of w*E*angle(dir,dir_macro)
+  G4double residual;		// Sum of |W*E_macro - sum(w*E)|
+};
+
+#endif	/* PhononMacroMerger_hh */
@@ -7,12 +7,24 @@
 
 // A custom physics list that inherits from the Geant4 modular physics list.
 // This will allow us to register multiple physics components.
+// A PhononSplittingProcess is added to the phonons for importance
+// splitting toward the KID.
+// With /g4cmp/ProcessTiming set before initialization, each phonon process
+// is replaced by a PhononTimedProcess wrapper to attribute CPU time.
+// With /g4cmp/HistoryFile set, the boundary process is first wrapped by
+// a PhononHistoryRecorder.
 
 class PhononPhysicsList : public G4VModularPhysicsList {
 public:
 	PhononPhysicsList(G4int verbose = 1);
 	virtual ~PhononPhysicsList();
+	virtual void ConstructProcess();
 	virtual void SetCuts();
+
+private:
+	void AddImportanceSplitting();
+	void RecordBoundaryHistories();
+	void WrapPhononProcesses();
 };
 
 #endif
\ No newline at end of file
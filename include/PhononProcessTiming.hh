@@ -0,0 +1,47 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononProcessTiming_hh
+#define PhononProcessTiming_hh 1
+
+// $Id$
+// File:  PhononProcessTiming.hh
+//
+// Description:	Run-level accumulable of per-process call counts and CPU
+//		time, collected from this thread's PhononTimedProcess
+//		wrappers and merged on master for the end-of-run report.
+
+#include "G4VAccumulable.hh"
+#include "globals.hh"
+#include <iosfwd>
+#include <map>
+
+
+class PhononProcessTiming : public G4VAccumulable {
+public:
+  PhononProcessTiming(const G4String& name="PhononProcessTiming");
+  virtual ~PhononProcessTiming() {;}
+
+  // Add this thread's wrapper counters (call once, at end of run)
+  void Collect();
+
+  virtual void Merge(const G4VAccumulable& other);
+  virtual void Reset();		// Also clears this thread's wrappers
+
+  G4bool IsEmpty() const { return timing.empty(); }
+  void Report(std::ostream& os) const;
+
+private:
+  struct Timing {
+    G4long lengthCalls = 0;
+    G4long doItCalls = 0;
+    G4double lengthTime = 0.;	// seconds
+    G4double doItTime = 0.;
+  };
+
+  std::map<G4String, Timing> timing;	// Keyed by process name
+};
+
+#endif	/* PhononProcessTiming_hh */
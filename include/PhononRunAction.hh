@@ -0,0 +1,68 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononRunAction_hh
+#define PhononRunAction_hh 1
+
+// $Id$
+// File:  PhononRunAction.hh
+//
+// Description:	Run action for G4CMP phonon example.  On the master
+//		thread, starts and stops the progress heartbeat (see
+//		PhononRunProgress) and prints the end-of-run summary.  On
+//		worker threads, reopens the hit and tracking output files
+//		so that filename changes take effect without a geometry
+//		rebuild.
+//
+//		Run-level tallies are owned here and registered with the
+//		G4AccumulableManager, which merges worker copies on master;
+//		see PhononAccumulable for the cycle they share.
+//		The adaptive run length feed is per thread and reports to
+//		the shared PhononRunLength controller instead.
+
+#include "G4UserRunAction.hh"
+#include "PhononBatchMonitor.hh"
+#include "PhononEnergyTally.hh"
+#include "PhononImportanceSplitter.hh"
+#include "PhononMacroMerger.hh"
+#include "PhononScanTally.hh"
+#include "PhononTrajectoryTracer.hh"
+#include "PhononProcessTiming.hh"
+#include <vector>
+
+class G4Run;
+class PhononStackingAction;
+class PhononSteppingAction;
+
+
+class PhononRunAction : public G4UserRunAction {
+public:
+  PhononRunAction(PhononSteppingAction* stepping=0,
+		  PhononStackingAction* stacking=0);
+  virtual ~PhononRunAction();
+
+  virtual void BeginOfRunAction(const G4Run* run);
+  virtual void EndOfRunAction(const G4Run* run);
+
+  // Filled per event by PhononEventAction
+  PhononScanTally* GetScanTally() { return &scanTally; }
+  PhononBatchMonitor* GetBatchMonitor() { return &batchMonitor; }
+  PhononTrajectoryTracer* GetTracer() { return &tracer; }
+
+private:
+  void OpenOutputFiles(G4int runID);
+
+  PhononSteppingAction* steppingAction;	// Null on master thread
+  PhononEnergyTally energyTally;
+  PhononProcessTiming processTiming;
+  PhononImportanceSplitter splitter;
+  PhononMacroMerger macroMerger;
+  PhononScanTally scanTally;
+  std::vector<PhononAccumulable*> tallies;	// All of the above but timing
+  PhononBatchMonitor batchMonitor;
+  PhononTrajectoryTracer tracer;
+};
+
+#endif	/* PhononRunAction_hh */
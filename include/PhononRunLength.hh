@@ -0,0 +1,91 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononRunLength_hh
+#define PhononRunLength_hh 1
+
+// $Id$
+// File:  PhononRunLength.hh
+//
+// Description:	Singleton controller for adaptive run length.  Workers
+//		(see PhononBatchMonitor) hand in fixed-size batches of
+//		event sums; after each batch the controller recomputes the
+//		batch-means uncertainty of the selected ratio estimators,
+//		and once all are within the target relative uncertainty it
+//		raises a stop flag.  Workers seeing the flag soft-abort
+//		their event loop, so the master hands out no more events.
+//		The /run/beamOn count is the cap.
+//
+//		With several workers, batches arrive in an order set by
+//		thread scheduling, so the batch at which the target is met,
+//		and the estimates, differ between otherwise identical runs.
+//		Events in batches arriving after the stop, and in each
+//		worker's final partial batch, are not used; both are
+//		counted and reported.
+//
+//		Estimators (ratio of sums, numerator / denominator):
+//		  kid  KID absorbed energy / injected energy
+//		  eta  KID energy absorbed within etaWindow / injected
+//		       (the efficiency integral of scattering_plot.C)
+//		  tau  energy-weighted mean KID arrival time, which is
+//		       tau_ph for an exponential arrival distribution
+
+#include "globals.hh"
+#include <atomic>
+#include <iosfwd>
+#include <mutex>
+#include <vector>
+
+
+class PhononRunLength {
+public:
+  enum Estimator { kKID, kEta, kTau, kNEstimators };
+
+  struct Sums {
+    G4double num[kNEstimators] = {};
+    G4double den[kNEstimators] = {};
+    G4long events = 0;
+  };
+
+  static PhononRunLength* Instance();
+
+  // Master: read target and estimators from PhononConfigManager
+  void BeginRun();
+  G4bool IsActive() const { return target > 0.; }
+
+  // Workers: add one full batch and re-evaluate the stopping rule
+  void AddBatch(const Sums& batch);
+
+  // Workers, at end of run: count events left in an incomplete batch
+  void DiscardPartial(G4long events);
+  G4bool StopRequested() const { return stop.load(std::memory_order_relaxed); }
+
+  // Estimates, uncertainties and stopping status (master, after run)
+  void Report(std::ostream& os) const;
+
+  static const char* GetName(G4int estimator);
+
+  // Ratio of sums over batches and its batch-means standard error
+  static void Estimate(const std::vector<Sums>& batches, G4int estimator,
+		       G4double& value, G4double& error);
+
+private:
+  PhononRunLength();
+  PhononRunLength(const PhononRunLength&) = delete;
+  PhononRunLength& operator=(const PhononRunLength&) = delete;
+
+  static PhononRunLength* theInstance;
+
+  mutable std::mutex batchMutex;
+  G4double target;			// Relative uncertainty (0 = off)
+  std::vector<G4int> selected;		// Estimators which must converge
+  std::vector<Sums> batches;
+  std::atomic<G4bool> stop;
+  G4long eventsAtStop;
+  G4long lateEvents;			// In batches arriving after the stop
+  G4long partialEvents;			// In partial batches at end of run
+};
+
+#endif	/* PhononRunLength_hh */
@@ -0,0 +1,89 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononRunProgress_hh
+#define PhononRunProgress_hh 1
+
+// $Id$
+// File:  PhononRunProgress.hh
+//
+// Description:	Singleton registry of live run counters for the phonon
+//		example.  Each worker thread owns one cache-aligned block of
+//		relaxed atomics (events completed, tracks currently alive),
+//		written from its event and tracking actions.  The master
+//		thread reads them from a background heartbeat, which prints
+//		throughput, memory and ETA to std::cout and to a status file
+//		at a fixed interval (see PhononConfigManager; off by default).
+//		The heartbeat is not a Geant4 thread, so it must not use G4cout.
+//
+//		In batch mode the master is inside BeamOn for the whole run,
+//		so /g4cmp/Progress only answers between runs; the heartbeat
+//		and status file are the way to follow a run in progress.
+
+#include "globals.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+class PhononRunProgress {
+public:
+  // Per-thread counters, aligned to keep workers off each other's lines
+  struct alignas(64) Counters {
+    std::atomic<G4int> events{0};	// Events completed in current run
+    std::atomic<G4int> liveTracks{0};	// Tracks in flight or stacked
+  };
+
+  ~PhononRunProgress();
+  static PhononRunProgress* Instance();
+
+  // Counters for given thread (G4Threading ID); created on first request
+  Counters* GetCounters(G4int threadID);
+
+  // Called by master run action to reset counters and (optionally) start
+  // the heartbeat thread; interval <= 0 disables the heartbeat
+  void BeginRun(G4int runID, G4int nEvents, G4double interval,
+		const G4String& statusFile);
+  void EndRun();
+
+  // Write one-line snapshot of current counters (for UI and heartbeat)
+  void Report(std::ostream& os) const;
+
+  // Resident memory of this process in bytes (0 if not available)
+  static G4double GetResidentMemory();
+
+private:
+  PhononRunProgress();
+  PhononRunProgress(const PhononRunProgress&) = delete;
+  PhononRunProgress& operator=(const PhononRunProgress&) = delete;
+
+  void Heartbeat();		// Body of background thread
+  void WriteStatusFile() const;
+
+  static PhononRunProgress* theInstance;
+
+private:
+  mutable std::mutex countersMutex;	// Guards map and runStart, not
+  std::map<G4int, std::unique_ptr<Counters> > counters;	// counter values
+  std::chrono::steady_clock::time_point runStart;
+
+  std::atomic<G4int> runID;
+  std::atomic<G4int> eventsToProcess;
+  std::atomic<G4bool> running;
+
+  std::thread heartbeat;
+  std::mutex heartbeatMutex;
+  std::condition_variable heartbeatWake;
+  G4bool stopHeartbeat;
+  G4double heartbeatInterval;	// Geant4 time units
+  G4String statusFile;
+};
+
+#endif	/* PhononRunProgress_hh */
@@ -0,0 +1,76 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononScanTally_hh
+#define PhononScanTally_hh 1
+
+// $Id$
+// File:  PhononScanTally.hh
+//
+// Description:	Per-injection-point response tally for position scans.
+//		With a scan grid configured (see PhononConfigManager), event
+//		N is injected at grid point N % nPoints, so each worker
+//		covers a share of every point.  Energy absorbed in the KID,
+//		feedline and Teflon supports is summed per event, and added
+//		to that event's point at end of event along with the
+//		injected energy.  KID arrival times are accumulated as
+//		energy-weighted moments.
+//
+//		The KID efficiency is the ratio of sums R = sum(a)/sum(d)
+//		of absorbed and injected energy.  Its error is the delta
+//		method estimate from the residuals z = a - R*d, which needs
+//		the per-event sums of a^2, d^2 and a*d.
+//
+//		Worker tallies are merged on master via G4AccumulableManager
+//		and written as one CSV row per grid point.
+
+#include "PhononAccumulable.hh"
+#include "globals.hh"
+#include <vector>
+
+
+class PhononScanTally : public PhononAccumulableT<PhononScanTally> {
+public:
+  enum Sensor { kKID, kFeedline, kTeflon, kNSensors };
+
+  PhononScanTally(const G4String& name="PhononScanTally");
+  virtual ~PhononScanTally() {;}
+
+  // Size tally from scan grid; inactive if no grid is configured
+  virtual void Configure();
+  virtual G4bool IsActive() const { return !points.empty(); }
+
+  // Absorption in named volume (weight included), during current event
+  void Score(const G4String& volume, G4double energy, G4double time);
+
+  void BeginEvent();
+  void EndEvent(G4int eventID, G4double injectedEnergy);
+
+  void Add(const PhononScanTally& other);
+  virtual void Reset();
+
+  // Write merged tally to the configured file and print a summary
+  virtual void EndOfRun(G4int runID, std::ostream& os) const;
+
+  // Write merged tally (master only); returns false on I/O error
+  G4bool Write(const G4String& fileName) const;
+
+private:
+  struct Point {
+    G4long events = 0;
+    G4double injected = 0.;
+    G4double absorbed[kNSensors] = { 0., 0., 0. };
+    G4double kidSq = 0.;	// Per-event sums of KID^2, injected^2 and
+    G4double injectedSq = 0.;	// KID*injected, for the efficiency error
+    G4double kidInjected = 0.;
+    G4double kidTime = 0.;	// Energy-weighted sums of KID arrival time
+    G4double kidTimeSq = 0.;
+  };
+
+  std::vector<Point> points;
+  Point event;			// Sums for event in progress
+};
+
+#endif	/* PhononScanTally_hh */
@@ -25,6 +25,7 @@ public:
 
   virtual void EndOfEvent(G4HCofThisEvent*);
 
+  // Reopens only if name or format (PhononConfigManager) has changed
   void SetOutputFile(const G4String& fn);
 
 protected:
@@ -33,6 +34,8 @@ protected:
 private:
   std::ofstream output;
   G4String fileName;
+  G4String outputFormat;
+  char delimiter;
 };
 
 #endif
@@ -0,0 +1,46 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononSplittingProcess_hh
+#define PhononSplittingProcess_hh 1
+
+// $Id$
+// File:  PhononSplittingProcess.hh
+//
+// Description:	Forced process which applies the thread's importance
+//		splitting (see PhononImportanceSplitter) at the end of each
+//		phonon step.  Copies are returned as secondaries through
+//		the particle change, so the stepping manager sets their
+//		parent, creator process and touchable like any other, and
+//		weights and kills go through the usual particle change
+//		updates.  While splitting is inactive the process is not
+//		forced, so its DoIt is never called.  Added to all phonon
+//		modes by PhononPhysicsList.
+
+#include "G4VDiscreteProcess.hh"
+#include "G4ParticleChange.hh"
+
+
+class PhononSplittingProcess : public G4VDiscreteProcess {
+public:
+  PhononSplittingProcess(const G4String& name="phononImportanceSplitting");
+  virtual ~PhononSplittingProcess() {;}
+
+  virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+
+  virtual G4double PostStepGetPhysicalInteractionLength(const G4Track& track,
+			G4double previousStepSize, G4ForceCondition* condition);
+  virtual G4VParticleChange* PostStepDoIt(const G4Track& track,
+					  const G4Step& step);
+
+protected:
+  virtual G4double GetMeanFreePath(const G4Track&, G4double,
+				   G4ForceCondition*) { return DBL_MAX; }
+
+private:
+  G4ParticleChange change;
+};
+
+#endif	/* PhononSplittingProcess_hh */
@@ -0,0 +1,50 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononStackingAction_hh
+#define PhononStackingAction_hh 1
+
+// $Id$
+// File:  PhononStackingAction.hh
+//
+// Description:	Stacking action for G4CMP phonon example.  When macro-
+//		phonon merging is enabled and the event holds more tracks
+//		than the merging cap, downconversion secondaries are sent
+//		to the waiting stack, so that the generation is complete
+//		when NewStage() is called; below the cap they are tracked
+//		as usual.  The stage is then reclassified twice: once to
+//		collect the tracks for PhononMacroMerger, and once to kill
+//		those it merged away, after which the macro-phonons which
+//		replace them are stacked.
+
+#include "G4CMPStackingAction.hh"
+#include <unordered_set>
+#include <vector>
+
+class PhononMacroMerger;
+
+
+class PhononStackingAction : public G4CMPStackingAction {
+public:
+  PhononStackingAction();
+  virtual ~PhononStackingAction() {;}
+
+  virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+  virtual void NewStage();
+  virtual void PrepareNewEvent();
+
+  // Per-thread merger, owned by PhononRunAction
+  void SetMacroMerger(PhononMacroMerger* merger) { macroMerger = merger; }
+
+private:
+  enum Mode { kStacking, kCollecting, kDiscarding };
+
+  PhononMacroMerger* macroMerger;
+  Mode mode;
+  std::vector<const G4Track*> stage;
+  std::unordered_set<const G4Track*> discard;
+};
+
+#endif	/* PhononStackingAction_hh */
@@ -2,8 +2,14 @@
 #define PHONONSTEPPINGACTION_H
 
 #include "G4UserSteppingAction.hh"
+#include "globals.hh"
 #include <fstream>
 
+class PhononEnergyTally;
+class PhononScanTally;
+class PhononBatchMonitor;
+class PhononTrajectoryTracer;
+
 /// SteppingAction to record every phonon step into a CSV file.
 class PhononSteppingAction : public G4UserSteppingAction {
 public:
@@ -14,8 +20,31 @@ public:
     /// @param step pointer to the current G4Step (see G4UserSteppingAction docs :contentReference[oaicite:2]{index=2}).
     void UserSteppingAction(const G4Step* step) override;
 
+    /// Reopen output (called by PhononRunAction at start of each run).
+    /// Nothing is done if the name and PhononConfigManager format are unchanged.
+    void SetOutputFile(const G4String& fileName);
+
+    /// Per-thread energy-density tally, owned by PhononRunAction.
+    void SetEnergyTally(PhononEnergyTally* tally) { energyTally_ = tally; }
+
+    /// Per-thread injection scan tally, owned by PhononRunAction.
+    void SetScanTally(PhononScanTally* tally) { scanTally_ = tally; }
+
+    /// Per-thread adaptive run length feed, owned by PhononRunAction.
+    void SetBatchMonitor(PhononBatchMonitor* monitor) { batchMonitor_ = monitor; }
+
+    /// Per-thread sampled trajectory tracer, owned by PhononRunAction.
+    void SetTracer(PhononTrajectoryTracer* tracer) { tracer_ = tracer; }
+
 private:
     std::ofstream fout_;
+    G4String fileName_;
+    G4String format_;
+    char delim_;
+    PhononEnergyTally* energyTally_;
+    PhononScanTally* scanTally_;
+    PhononBatchMonitor* batchMonitor_;
+    PhononTrajectoryTracer* tracer_;
 };
 
 #endif // PHONONSTEPPINGACTION_H
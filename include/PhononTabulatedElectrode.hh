@@ -0,0 +1,83 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononTabulatedElectrode_hh
+#define PhononTabulatedElectrode_hh 1
+
+// $Id$
+// File:  PhononTabulatedElectrode.hh
+//
+// Description:	Phonon sensor which replaces the per-phonon KaplanQP
+//		quasiparticle cascade with tables sampled from it.  For a
+//		log-spaced grid of incident energies above the pair-breaking
+//		threshold, KaplanQP is run a fixed number of times and each
+//		outcome (the re-emitted phonon energies, as fractions of the
+//		incident energy) is stored.  At run time an outcome is drawn
+//		from one of the grid points bracketing the phonon energy and
+//		scaled to it; the absorbed energy is whatever is not
+//		re-emitted, so energy is conserved exactly.  Below
+//		threshold, and above the grid, KaplanQP is cheap or rare and
+//		is called directly.
+//
+//		Scaling moves each re-emitted energy by up to one grid step.
+//		An outcome in which that would carry a phonon across the
+//		pair-breaking threshold 2*gap, changing what it can do in
+//		the next film, is not used; KaplanQP is run directly instead.
+//
+//		The table is built when the electrode is constructed, during
+//		detector construction on master, and is immutable after
+//		that; clones share it.  It is built with a private engine
+//		seeded from the film properties, so it is reproducible.
+
+#include "G4CMPPhononElectrode.hh"
+#include "globals.hh"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class G4MaterialPropertiesTable;
+
+
+class PhononTabulatedElectrode : public G4CMPPhononElectrode {
+public:
+  // Film properties must be complete, and FilmTableSamples set
+  PhononTabulatedElectrode(const G4MaterialPropertiesTable* film);
+  virtual ~PhononTabulatedElectrode() {;}
+
+  virtual G4CMPVElectrodePattern* Clone() const {
+    return new PhononTabulatedElectrode(*this);
+  }
+
+  virtual void AbsorbAtElectrode(const G4Track& track, const G4Step& step,
+				 G4ParticleChange& particleChange) const;
+
+private:
+  struct Table {
+    G4double minEnergy;			// Pair-breaking threshold, 2*gap
+    G4double maxEnergy;
+    G4double logStep;			// Spacing of ln(E) grid
+    G4int nEnergies;
+    G4int nSamples;			// Outcomes per grid energy
+    std::vector<size_t> first;		// Per outcome, index into fractions
+    std::vector<G4double> fractions;	// Re-emitted E / incident E
+  };
+
+  static std::shared_ptr<const Table>
+  GetTable(const G4MaterialPropertiesTable* film);
+
+  static std::shared_ptr<const Table>
+  BuildTable(const G4MaterialPropertiesTable* film);
+
+  // Fill re-emitted phonon energies; returns absorbed energy
+  G4double Sample(G4double energy, std::vector<G4double>& reflected) const;
+
+  std::shared_ptr<const Table> table;
+
+  static std::map<G4String, std::shared_ptr<const Table> > tableCache;
+  static std::mutex tableMutex;
+};
+
+#endif	/* PhononTabulatedElectrode_hh */
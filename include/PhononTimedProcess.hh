@@ -0,0 +1,53 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononTimedProcess_hh
+#define PhononTimedProcess_hh 1
+
+// $Id$
+// File:  PhononTimedProcess.hh
+//
+// Description:	Wrapper which forwards everything to a registered
+//		process, accumulating call counts and the CPU time of the
+//		calling thread spent in PostStepGetPhysicalInteractionLength
+//		and PostStepDoIt.  Thread CPU time (POSIX
+//		CLOCK_THREAD_CPUTIME_ID) is not inflated by preemption when
+//		workers outnumber cores, as wall-clock time would be.
+//		Installed by PhononPhysicsList when /g4cmp/ProcessTiming is
+//		set.  Each thread builds its own wrappers; counters are read
+//		back per thread by PhononProcessTiming at end of run.
+
+#include "G4WrapperProcess.hh"
+#include <vector>
+
+
+class PhononTimedProcess : public G4WrapperProcess {
+public:
+  PhononTimedProcess(G4VProcess* process);
+  virtual ~PhononTimedProcess();
+
+  virtual G4double PostStepGetPhysicalInteractionLength(const G4Track& track,
+			G4double previousStepSize, G4ForceCondition* condition);
+  virtual G4VParticleChange* PostStepDoIt(const G4Track& track,
+					  const G4Step& step);
+
+  // Counters since last reset
+  G4long GetLengthCalls() const { return lengthCalls; }
+  G4long GetDoItCalls() const { return doItCalls; }
+  G4double GetLengthTime() const { return lengthTime; }	// CPU seconds
+  G4double GetDoItTime() const { return doItTime; }	// CPU seconds
+  void ResetTimers();
+
+  // All wrappers built on the calling thread
+  static const std::vector<PhononTimedProcess*>& GetThreadProcesses();
+
+private:
+  G4long lengthCalls;
+  G4long doItCalls;
+  G4double lengthTime;
+  G4double doItTime;
+};
+
+#endif	/* PhononTimedProcess_hh */
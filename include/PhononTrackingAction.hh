@@ -0,0 +1,35 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononTrackingAction_hh
+#define PhononTrackingAction_hh 1
+
+// $Id$
+// File:  PhononTrackingAction.hh
+//
+// Description:	Tracking action for G4CMP phonon example.  Publishes the
+//		number of live tracks (current plus stacked) on this worker
+//		to the shared progress counters, and brackets each track
+//		for the boundary history recorder when one is installed.
+
+#include "G4UserTrackingAction.hh"
+#include "PhononRunProgress.hh"
+
+class G4Track;
+
+
+class PhononTrackingAction : public G4UserTrackingAction {
+public:
+  PhononTrackingAction();
+  virtual ~PhononTrackingAction();
+
+  virtual void PreUserTrackingAction(const G4Track* track);
+  virtual void PostUserTrackingAction(const G4Track* track);
+
+private:
+  PhononRunProgress::Counters* progress;	// Owned by PhononRunProgress
+};
+
+#endif	/* PhononTrackingAction_hh */
@@ -0,0 +1,72 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+#ifndef PhononTrajectoryTracer_hh
+#define PhononTrajectoryTracer_hh 1
+
+// $Id$
+// File:  PhononTrajectoryTracer.hh
+//
+// Description:	Per-thread sampled trajectory tracing.  With a trace rate
+//		of N, one in N tracks (or events) is chosen by a hash of
+//		run, event and track ID, so the same sample is traced for
+//		any thread count.  Every step of a chosen track is buffered
+//		and written at end of event; steps beyond the buffer size
+//		are dropped and counted in the file.  The rate is read at
+//		the start of each run, like the other settings; zero costs
+//		one comparison per step.
+
+#include "globals.hh"
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+class G4Step;
+class G4Track;
+
+
+class PhononTrajectoryTracer {
+public:
+  PhononTrajectoryTracer();
+
+  // Rate, mode, buffer size and file from PhononConfigManager; file is
+  // only opened once something has been traced
+  void Configure(G4int runID, const G4String& fileName);
+
+  void Record(const G4Step* step);
+  void EndEvent();
+
+  // Flush and close at end of run; a file kept for the next run is
+  // reopened for append
+  void Close();
+
+  // Sampling decision; depends only on the IDs, not on the thread
+  static G4bool IsSelected(G4int runID, G4int eventID, G4int trackID,
+			   G4int rate, G4bool eventMode);
+
+private:
+  void Select(const G4Track* track);
+  void WriteStep(const G4Track* track, const G4Step* step, G4bool pre);
+
+  static uint64_t Hash(uint64_t key);
+
+  G4int runID;
+  G4int rate;			// Trace 1 in rate (0 = off)
+  G4bool eventMode;		// Sample whole events, not single tracks
+  G4int bufferSize;		// Maximum steps held per event
+  G4String fileName;
+  std::ofstream fout;
+  G4bool append;		// fileName already written by an earlier run
+  char delim;
+
+  G4int trackID;		// Track in progress, and whether traced
+  G4bool selected;
+
+  std::ostringstream buffer;
+  G4int buffered;
+  G4long dropped;
+};
+
+#endif	/* PhononTrajectoryTracer_hh */
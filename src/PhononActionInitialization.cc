@@ -6,12 +6,27 @@
 // $Id: 539f524339ae53ad098a07cfa3bebd07784d23dd $
 
 #include "PhononActionInitialization.hh"
+#include "PhononEventAction.hh"
 #include "PhononPrimaryGeneratorAction.hh"
-#include "G4CMPStackingAction.hh"
+#include "PhononRunAction.hh"
+#include "PhononStackingAction.hh"
 #include "PhononSteppingAction.hh"
+#include "PhononTrackingAction.hh"
+
+void PhononActionInitialization::BuildForMaster() const {
+  SetUserAction(new PhononRunAction);
+}
 
 void PhononActionInitialization::Build() const {
+  PhononSteppingAction* stepping = new PhononSteppingAction;
+  PhononStackingAction* stacking = new PhononStackingAction;
+
+  PhononRunAction* run = new PhononRunAction(stepping, stacking);
+
   SetUserAction(new PhononPrimaryGeneratorAction);
-  SetUserAction(new G4CMPStackingAction);
-  SetUserAction(new PhononSteppingAction);
+  SetUserAction(run);
+  SetUserAction(new PhononEventAction(run));
+  SetUserAction(stacking);
+  SetUserAction(new PhononTrackingAction);
+  SetUserAction(stepping);
 } 
@@ -0,0 +1,71 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononAllocHooks.cc
+//
+// Description:	Replacement global operator new and delete which feed
+//		PhononAllocProfile.  Built into the executable only, and
+//		only with the CMake option G4CMP_PHONON_ALLOC_HOOKS, so
+//		that the library never replaces its host's allocator.
+//
+//		Allocations and frees are both counted with the usable size
+//		of the block, as the unsized operator delete has no other
+//		way to know it.  Array and aligned forms are not replaced;
+//		the array forms forward to these by default.
+
+#include "PhononAllocProfile.hh"
+#include <cstdlib>
+#include <new>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#error "PhononAllocHooks needs malloc_usable_size() or malloc_size()"
+#endif
+
+
+namespace {
+  size_t UsableSize(void* ptr) {
+#ifdef __APPLE__
+    return malloc_size(ptr);
+#else
+    return malloc_usable_size(ptr);
+#endif
+  }
+
+  const G4bool installed = (PhononAllocProfile::NoteHooksInstalled(), true);
+}
+
+
+// With profiling off, the only cost over the default is a relaxed load
+// of the enable flag
+
+void* operator new(std::size_t size) {
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  if (PhononAllocProfile::IsEnabled())
+    PhononAllocProfile::CountAlloc(UsableSize(ptr));
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  void* ptr = std::malloc(size ? size : 1);
+  if (ptr && PhononAllocProfile::IsEnabled())
+    PhononAllocProfile::CountAlloc(UsableSize(ptr));
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (!ptr) return;
+  if (PhononAllocProfile::IsEnabled())
+    PhononAllocProfile::CountFree(UsableSize(ptr));
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  operator delete(ptr);
+}
@@ -0,0 +1,145 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononAllocProfile.cc
+//
+// Description:	Opt-in heap and memory-footprint profile for the phonon
+//		example.  The allocation hooks which feed it are in
+//		PhononAllocHooks.cc.
+
+#include "PhononAllocProfile.hh"
+#include "PhononRunProgress.hh"
+#include "G4Threading.hh"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sys/resource.h>
+
+
+// Constructor and Singleton Initializer
+
+PhononAllocProfile* PhononAllocProfile::theInstance = 0;
+std::atomic<G4bool> PhononAllocProfile::enabled(false);
+G4bool PhononAllocProfile::hooksInstalled = false;
+thread_local PhononAllocProfile::Counters* PhononAllocProfile::threadCounters = 0;
+thread_local PhononAllocProfile::Phase PhononAllocProfile::threadPhase = PhononAllocProfile::kOther;
+
+PhononAllocProfile* PhononAllocProfile::Instance() {
+  static std::once_flag created;
+  std::call_once(created, [] { theInstance = new PhononAllocProfile; });
+  return theInstance;
+}
+
+
+// Master runs this before any worker starts its run
+
+void PhononAllocProfile::BeginRun(G4bool enable) {
+  {
+    std::lock_guard<std::mutex> lock(countersMutex);
+    for (auto& slot : counters) *slot.second = Counters();
+  }
+
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+void PhononAllocProfile::RegisterThread() {
+  if (threadCounters) return;
+
+  std::lock_guard<std::mutex> lock(countersMutex);
+  std::unique_ptr<Counters>& slot = counters[G4Threading::G4GetThreadId()];
+  if (!slot) slot.reset(new Counters);
+  threadCounters = slot.get();
+}
+
+
+void PhononAllocProfile::NoteLiveTracks(G4int nTracks) {
+  if (Counters* c = threadCounters)
+    c->eventPeakTracks = std::max(c->eventPeakTracks, nTracks);
+}
+
+// RSS is read with this thread detached, so that the stream reading it
+// does not count its own allocations against the event
+
+void PhononAllocProfile::EndEvent() {
+  Counters* c = threadCounters;
+  if (!c) return;
+
+  threadCounters = 0;
+  G4double rss = PhononRunProgress::GetResidentMemory();
+  threadCounters = c;
+
+  c->events++;
+  c->maxEventBytes = std::max(c->maxEventBytes, c->eventBytes);
+  c->maxEventTracks = std::max(c->maxEventTracks, c->eventPeakTracks);
+  c->sumEventTracks += c->eventPeakTracks;
+  c->maxRSS = std::max(c->maxRSS, rss);
+
+  c->eventBytes = 0;
+  c->eventPeakTracks = 0;
+}
+
+
+// Thread -1 is the master in MT mode
+
+void PhononAllocProfile::Report(std::ostream& os) const {
+  const char* phaseNames[kNPhases] = { "other", "generation", "tracking",
+				       "EndOfEvent", "output" };
+  const G4double MB = 1024.*1024.;
+
+  std::lock_guard<std::mutex> lock(countersMutex);
+
+  if (!hooksInstalled) {
+    os << "Heap counts not available: build with"
+       << " -DG4CMP_PHONON_ALLOC_HOOKS=ON to install allocation hooks\n";
+  }
+
+  os << "Heap profile (allocations / MB allocated per phase)\n"
+     << std::setw(7) << "thread" << std::setw(9) << "events";
+  for (const char* name : phaseNames) os << std::setw(22) << name;
+  os << std::setw(12) << "max/event" << std::setw(12) << "peak tracks"
+     << std::setw(12) << "mean peak" << '\n';
+
+  Counters total;
+  G4double maxRSS = 0.;
+  os << std::fixed << std::setprecision(1);
+  for (const auto& slot : counters) {
+    const Counters& c = *slot.second;
+    os << std::setw(7) << slot.first << std::setw(9) << c.events;
+    for (G4int p=0; p<kNPhases; p++) {
+      os << std::setw(12) << c.allocs[p] << " / " << std::setw(7)
+	 << c.bytes[p]/MB;
+      total.allocs[p] += c.allocs[p];
+      total.bytes[p] += c.bytes[p];
+      total.freedBytes[p] += c.freedBytes[p];
+    }
+    os << std::setw(9) << c.maxEventBytes/MB << " MB"
+       << std::setw(12) << c.maxEventTracks
+       << std::setw(12) << (c.events > 0 ? c.sumEventTracks/c.events : 0.)
+       << '\n';
+    maxRSS = std::max(maxRSS, c.maxRSS);
+  }
+
+  os << std::setw(16) << "total";
+  for (G4int p=0; p<kNPhases; p++) {
+    os << std::setw(12) << total.allocs[p] << " / " << std::setw(7)
+       << total.bytes[p]/MB;
+  }
+
+  // Memory is often freed in a later phase than it was allocated
+  G4double allocated = 0., freed = 0.;
+  for (G4int p=0; p<kNPhases; p++) {
+    allocated += total.bytes[p];
+    freed += total.freedBytes[p];
+  }
+
+  struct rusage usage;
+  G4double peakRSS = (getrusage(RUSAGE_SELF, &usage) == 0)
+    ? usage.ru_maxrss*1024. : 0.;		// Linux reports kB
+
+  os << "\nNet retained " << (allocated-freed)/MB
+     << " MB, largest end-of-event RSS " << maxRSS/MB << " MB, process peak RSS "
+     << peakRSS/MB << " MB" << std::defaultfloat << std::endl;
+}
@@ -0,0 +1,69 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononBatchMonitor.cc
+//
+// Description:	Per-thread feed of event batches for adaptive run length.
+
+#include "PhononBatchMonitor.hh"
+#include "PhononConfigManager.hh"
+#include "G4SystemOfUnits.hh"
+
+
+namespace {
+  // Histogram range used for the efficiency integral in scattering_plot.C
+  const G4double etaWindow = 150.4*us;
+}
+
+
+PhononBatchMonitor::PhononBatchMonitor()
+  : active(false), batchSize(1), kidEnergy(0.), kidEnergyWindow(0.),
+    kidTime(0.) {;}
+
+
+void PhononBatchMonitor::Configure() {
+  active = PhononRunLength::Instance()->IsActive();
+  batchSize = PhononConfigManager::GetBatchSize();
+  batch = PhononRunLength::Sums();
+  kidEnergy = kidEnergyWindow = kidTime = 0.;
+}
+
+
+void PhononBatchMonitor::Score(const G4String& volume, G4double energy,
+			       G4double time) {
+  if (volume != "KID") return;
+
+  kidEnergy += energy;
+  kidTime += energy*time;
+  if (time < etaWindow) kidEnergyWindow += energy;
+}
+
+
+G4bool PhononBatchMonitor::EndEvent(G4double injectedEnergy) {
+  batch.num[PhononRunLength::kKID] += kidEnergy;
+  batch.den[PhononRunLength::kKID] += injectedEnergy;
+  batch.num[PhononRunLength::kEta] += kidEnergyWindow;
+  batch.den[PhononRunLength::kEta] += injectedEnergy;
+  batch.num[PhononRunLength::kTau] += kidTime;
+  batch.den[PhononRunLength::kTau] += kidEnergy;
+  batch.events++;
+
+  kidEnergy = kidEnergyWindow = kidTime = 0.;
+
+  PhononRunLength* controller = PhononRunLength::Instance();
+  if (batch.events >= batchSize) {
+    controller->AddBatch(batch);
+    batch = PhononRunLength::Sums();
+  }
+
+  return controller->StopRequested();
+}
+
+void PhononBatchMonitor::EndOfRun() {
+  if (active && batch.events > 0)
+    PhononRunLength::Instance()->DiscardPartial(batch.events);
+  batch = PhononRunLength::Sums();
+}
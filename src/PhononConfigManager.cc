@@ -12,10 +12,17 @@
 //		changed via macro commands (see PhononConfigMessenger).
 //
 // 20170816  M. Kelsey -- Extract hit filename from G4CMPConfigManager.
+// 20261019  Add settings for output files, directory and {run}/{thread}
+//		templates, progress reporting, energy and scan tallies,
+//		timing and heap profiling, importance splitting, film
+//		response, macro-phonon merging, adaptive run length,
+//		boundary histories and tracing.  Remove unused
+//		UpdateGeometry(); no setting here changes geometry.
 
 #include "PhononConfigManager.hh"
 #include "PhononConfigMessenger.hh"
-#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
 #include <stdlib.h>
 
 
@@ -29,7 +36,22 @@ PhononConfigManager* PhononConfigManager::Instance() {
 }
 
 PhononConfigManager::PhononConfigManager()
-  : Hit_file(getenv("G4CMP_HIT_FILE")?getenv("G4CMP_HIT_FILE"):"phonon_hits.txt"),
+  : Hit_file(getenv("G4CMP_HIT_FILE")?getenv("G4CMP_HIT_FILE"):"phonon_hits_{run}_{thread}.txt"),
+    Track_file(getenv("G4CMP_TRACKING_FILE")?getenv("G4CMP_TRACKING_FILE"):"phonon_tracking_{run}_{thread}.csv"),
+    outputFormat("csv"),
+    outputDir(getenv("G4CMP_OUTPUT_DIR")?getenv("G4CMP_OUTPUT_DIR"):""),
+    tallyFile(""), tallyBins({40, 40, 1, 200}),
+    tallyTime(160.*us), tallyMaxVoxels(1<<19), processTiming(false),
+    allocProfile(false), historyFile(""),
+    splittingFactor(2), filmResponse("perfect"), filmTableSamples(500),
+    mergeMaxTracks(0), mergeTolerance(0.05), mergeDistance(50.*um),
+    scanBins({0, 0}), scanRange({-9.*mm, 9.*mm, -9.*mm, 9.*mm}),
+    scanSpotRadius(0.), scanFile("phonon_scan.csv"),
+    targetPrecision(0.), precisionEstimators({"kid"}), batchSize(100),
+    traceRate(0), traceMode("track"), traceFile("phonon_trace_{run}_{thread}.csv"),
+    traceBuffer(100000),
+    heartbeatInterval(0.),
+    statusFile(getenv("G4CMP_STATUS_FILE")?getenv("G4CMP_STATUS_FILE"):"phonon_status.txt"),
     messenger(new PhononConfigMessenger(this)) {;}
 
 PhononConfigManager::~PhononConfigManager() {
@@ -37,8 +59,58 @@ PhononConfigManager::~PhononConfigManager() {
 }
 
 
-// Trigger rebuild of geometry if parameters change
+// Scan points are grid nodes, so a 1-wide axis sits mid-range
 
-void PhononConfigManager::UpdateGeometry() {
-  G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+G4ThreeVector PhononConfigManager::GetScanPosition(G4int point) {
+  const std::vector<G4int>& n = Instance()->scanBins;
+  const std::vector<G4double>& range = Instance()->scanRange;
+
+  G4int ix = point % n[0];
+  G4int iy = point / n[0];
+  G4double fx = (n[0] > 1) ? G4double(ix)/(n[0]-1) : 0.5;
+  G4double fy = (n[1] > 1) ? G4double(iy)/(n[1]-1) : 0.5;
+
+  return G4ThreeVector(range[0] + fx*(range[1]-range[0]),
+		       range[2] + fy*(range[3]-range[2]), 0.);
+}
+
+
+// Substitute run and thread numbers into output filename, and apply
+// output directory.  Workers must not share a file, so a worker name
+// without {thread} gets "_<thread>" before its extension.
+
+G4String PhononConfigManager::GetOutputName(const G4String& pattern,
+					    G4int runID) {
+  return GetOutputName(pattern, runID, G4Threading::G4GetThreadId());
+}
+
+G4String PhononConfigManager::GetOutputName(const G4String& pattern,
+					    G4int runID, G4int threadID) {
+  G4String name = pattern;
+
+  if (threadID >= 0 && !name.empty() &&
+      name.find("{thread}") == G4String::npos) {
+    size_t base = name.find_last_of('/');
+    size_t ext = name.find_last_of('.');
+    if (ext == G4String::npos || (base != G4String::npos && ext < base))
+      ext = name.length();
+    name.insert(ext, "_{thread}");
+  }
+
+  const std::pair<G4String, G4String> tokens[] = {
+    { "{run}", std::to_string(runID) },
+    { "{thread}", std::to_string(threadID) },
+  };
+
+  for (const auto& token : tokens) {
+    size_t pos;
+    while ((pos = name.find(token.first)) != G4String::npos)
+      name.replace(pos, token.first.length(), token.second);
+  }
+
+  const G4String& dir = Instance()->outputDir;
+  if (!dir.empty() && !name.empty() && name[0] != '/') name = dir + "/" + name;
+
+  return name;
 }
+
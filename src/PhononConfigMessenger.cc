@@ -10,29 +10,446 @@
 //		PhononConfigManager.
 //
 // 20170816  Michael Kelsey
+// 20261019  Add commands for output files and format, progress reporting,
+//		energy and scan tallies, timing and heap profiling,
+//		importance splitting, film response, macro-phonon merging,
+//		adaptive run length, boundary histories and tracing;
+//		group SetNewValue() by topic.
 
 #include "PhononConfigMessenger.hh"
 #include "PhononConfigManager.hh"
+#include "PhononRunProgress.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIparameter.hh"
+#include "G4SystemOfUnits.hh"
+#include <cstdlib>
+#include <sstream>
+#include <vector>
 
 
 // Constructor and destructor
 
 PhononConfigMessenger::PhononConfigMessenger(PhononConfigManager* mgr)
   : G4UImessenger("/g4cmp/", "User configuration for G4CMP phonon example"),
-    theManager(mgr), hitsCmd(0) {
+    theManager(mgr), hitsCmd(0), trackCmd(0), formatCmd(0), tallyFileCmd(0),
+    tallyBinsCmd(0), tallyTimeCmd(0), tallyMaxCmd(0), timingCmd(0),
+    allocCmd(0), historyCmd(0), shellsCmd(0), splitCmd(0), filmCmd(0),
+    filmSamplesCmd(0), mergeMaxCmd(0), mergeTolCmd(0), mergeDistCmd(0),
+    scanGridCmd(0), scanRangeCmd(0), scanSpotCmd(0), scanFileCmd(0),
+    precisionCmd(0), estimatorsCmd(0), batchCmd(0), traceRateCmd(0),
+    traceModeCmd(0), traceFileCmd(0), traceBufferCmd(0), heartbeatCmd(0),
+    statusCmd(0), progressCmd(0) {
   hitsCmd = CreateCommand<G4UIcmdWithAString>("HitsFile",
 			      "Set filename for output of phonon hit locations");
+  hitsCmd->SetGuidance("{run} and {thread} are replaced by run and thread ID;");
+  hitsCmd->SetGuidance("without {thread}, \"_<thread>\" is added before the");
+  hitsCmd->SetGuidance("extension so workers never share a file.  The file is");
+  hitsCmd->SetGuidance("reopened at the start of the next run.");
+
+  trackCmd = CreateCommand<G4UIcmdWithAString>("TrackingFile",
+			      "Set filename for output of phonon sensor crossings");
+  trackCmd->SetGuidance("{run} and {thread} are replaced by run and thread ID;");
+  trackCmd->SetGuidance("without {thread}, \"_<thread>\" is added before the");
+  trackCmd->SetGuidance("extension so workers never share a file.  The file is");
+  trackCmd->SetGuidance("reopened at the start of the next run.");
+
+  formatCmd = CreateCommand<G4UIcmdWithAString>("OutputFormat",
+			      "Select text format for hits and tracking output");
+  formatCmd->SetGuidance("\"none\" suppresses both files.");
+  formatCmd->SetCandidates("csv tsv none");
+
+  tallyFileCmd = CreateCommand<G4UIcmdWithAString>("EnergyTallyFile",
+			      "Set binary output file for substrate energy tally");
+  tallyFileCmd->SetGuidance("{run} is replaced by run ID; \"none\" disables.");
+
+  tallyBinsCmd = CreateCommand<G4UIcommand>("EnergyTallyBins",
+			      "Set number of energy tally bins in x, y, z, t");
+  for (const char* axis : { "nx", "ny", "nz", "nt" }) {
+    auto* param = new G4UIparameter(axis, 'i', false);
+    param->SetParameterRange(G4String(axis)+">0");
+    tallyBinsCmd->SetParameter(param);
+  }
+
+  tallyTimeCmd = CreateCommand<G4UIcmdWithADoubleAndUnit>("EnergyTallyTime",
+			      "Set end of energy tally time window");
+  tallyTimeCmd->SetParameterName("tmax", false);
+  tallyTimeCmd->SetRange("tmax>0");
+  tallyTimeCmd->SetDefaultUnit("us");
+
+  tallyMaxCmd = CreateCommand<G4UIcmdWithAnInteger>("EnergyTallyMaxVoxels",
+			      "Set cap on non-empty tally voxels per thread");
+  tallyMaxCmd->SetGuidance("Scores which do not fit are counted as overflow.");
+  tallyMaxCmd->SetParameterName("nmax", false);
+  tallyMaxCmd->SetRange("nmax>0");
+
+  timingCmd = CreateCommand<G4UIcmdWithABool>("ProcessTiming",
+			      "Time each phonon process, reported at end of run");
+  timingCmd->SetGuidance("Measures CPU time of the calling thread, not wall time.");
+  timingCmd->SetGuidance("Must be set before /run/initialize.");
+  timingCmd->SetParameterName("enable", true);
+  timingCmd->SetDefaultValue(true);
+  timingCmd->AvailableForStates(G4State_PreInit);
+
+  allocCmd = CreateCommand<G4UIcmdWithABool>("AllocationProfile",
+			      "Count heap use per thread and event phase");
+  allocCmd->SetGuidance("Also records per-event peak live tracks and RSS;");
+  allocCmd->SetGuidance("reported at end of each run.");
+  allocCmd->SetGuidance("Heap counts need the executable built with the");
+  allocCmd->SetGuidance("CMake option G4CMP_PHONON_ALLOC_HOOKS=ON.");
+  allocCmd->SetParameterName("enable", true);
+  allocCmd->SetDefaultValue(true);
+
+  historyCmd = CreateCommand<G4UIcmdWithAString>("HistoryFile",
+			      "Set binary output file for boundary histories");
+  historyCmd->SetGuidance("Records every phonon surface interaction for offline");
+  historyCmd->SetGuidance("reweighting with reweight_surfaces.C.  {run} and");
+  historyCmd->SetGuidance("{thread} are replaced by run and thread ID; each worker");
+  historyCmd->SetGuidance("writes its own file, so a name without {thread} gets");
+  historyCmd->SetGuidance("_<thread> added before its extension.");
+  historyCmd->SetGuidance("Recording must be enabled before /run/initialize;");
+  historyCmd->SetGuidance("afterwards the name may change, or \"none\" pause it.");
+  historyCmd->SetParameterName("file", true);
+  historyCmd->SetDefaultValue("phonon_history_{run}_{thread}.bin");
+  historyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  shellsCmd = CreateCommand<G4UIcmdWithAString>("ImportanceShells",
+			      "Set shell radii around KID for phonon splitting");
+  shellsCmd->SetGuidance("Distances from the KID footprint, optionally followed");
+  shellsCmd->SetGuidance("by a length unit (default mm), e.g. \"6 4 2 mm\".");
+  shellsCmd->SetGuidance("Each shell inward multiplies importance by the");
+  shellsCmd->SetGuidance("SplittingFactor.  \"none\" disables splitting.");
+  shellsCmd->SetGuidance("Splitting must be enabled before /run/initialize;");
+  shellsCmd->SetGuidance("afterwards the radii may change, or \"none\" pause it.");
+  shellsCmd->SetParameterName("radii", false);
+  shellsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  splitCmd = CreateCommand<G4UIcmdWithAnInteger>("SplittingFactor",
+			      "Set importance ratio between adjacent shells");
+  splitCmd->SetParameterName("factor", false);
+  splitCmd->SetRange("factor>=2");
+
+  filmCmd = CreateCommand<G4UIcmdWithAString>("FilmResponse",
+			      "Select phonon response of aluminium sensor films");
+  filmCmd->SetGuidance("perfect:   absorb every phonon reaching the film");
+  filmCmd->SetGuidance("kaplan:    run KaplanQP cascade for each phonon");
+  filmCmd->SetGuidance("tabulated: sample KaplanQP results tabulated once");
+  filmCmd->SetGuidance("           per film configuration");
+  filmCmd->SetGuidance("Must be set before /run/initialize.");
+  filmCmd->SetCandidates("perfect kaplan tabulated");
+  filmCmd->AvailableForStates(G4State_PreInit);
+
+  filmSamplesCmd = CreateCommand<G4UIcmdWithAnInteger>("FilmTableSamples",
+			      "Set KaplanQP samples per energy in film tables");
+  filmSamplesCmd->SetGuidance("Must be set before /run/initialize.");
+  filmSamplesCmd->SetParameterName("n", false);
+  filmSamplesCmd->SetRange("n>0");
+  filmSamplesCmd->AvailableForStates(G4State_PreInit);
+
+  mergeMaxCmd = CreateCommand<G4UIcmdWithAnInteger>("MergeMaxTracks",
+			      "Cap on each generation of downconversion phonons");
+  mergeMaxCmd->SetGuidance("Larger generations are merged into weighted");
+  mergeMaxCmd->SetGuidance("macro-phonons; zero disables merging.");
+  mergeMaxCmd->SetParameterName("nmax", false);
+  mergeMaxCmd->SetRange("nmax>=0");
+
+  mergeTolCmd = CreateCommand<G4UIcmdWithADouble>("MergeTolerance",
+			      "Set relative energy and direction merging width");
+  mergeTolCmd->SetGuidance("Widened by factors of two if needed to meet the cap.");
+  mergeTolCmd->SetParameterName("tol", false);
+  mergeTolCmd->SetRange("tol>0");
+
+  mergeDistCmd = CreateCommand<G4UIcmdWithADoubleAndUnit>("MergeDistance",
+			      "Set position width for macro-phonon merging");
+  mergeDistCmd->SetParameterName("dist", false);
+  mergeDistCmd->SetRange("dist>0");
+  mergeDistCmd->SetDefaultUnit("um");
+
+  scanGridCmd = CreateCommand<G4UIcommand>("ScanGrid",
+			      "Set number of injection points in x and y");
+  scanGridCmd->SetGuidance("Event N is injected at point N % (nx*ny) on the");
+  scanGridCmd->SetGuidance("substrate back face; \"0 0\" restores the");
+  scanGridCmd->SetGuidance("default injection spot.");
+  for (const char* axis : { "nx", "ny" }) {
+    auto* param = new G4UIparameter(axis, 'i', false);
+    param->SetParameterRange(G4String(axis)+">=0");
+    scanGridCmd->SetParameter(param);
+  }
+
+  scanRangeCmd = CreateCommand<G4UIcommand>("ScanRange",
+			      "Set extent of injection grid on the back face");
+  for (const char* edge : { "xmin", "xmax", "ymin", "ymax" })
+    scanRangeCmd->SetParameter(new G4UIparameter(edge, 'd', false));
+  auto* unitParam = new G4UIparameter("unit", 's', true);
+  unitParam->SetDefaultValue("mm");
+  scanRangeCmd->SetParameter(unitParam);
+
+  scanSpotCmd = CreateCommand<G4UIcmdWithADoubleAndUnit>("ScanSpotRadius",
+			      "Set radius of uniform injection disc at each point");
+  scanSpotCmd->SetParameterName("radius", false);
+  scanSpotCmd->SetRange("radius>=0");
+  scanSpotCmd->SetDefaultUnit("mm");
+
+  scanFileCmd = CreateCommand<G4UIcmdWithAString>("ScanFile",
+			      "Set CSV output file for per-point scan response");
+  scanFileCmd->SetGuidance("{run} is replaced by run ID.");
+
+  precisionCmd = CreateCommand<G4UIcmdWithADouble>("TargetPrecision",
+			      "Stop run once estimators reach relative uncertainty");
+  precisionCmd->SetGuidance("Uncertainties are from batch means over all workers;");
+  precisionCmd->SetGuidance("/run/beamOn sets the cap on events.  Zero disables.");
+  precisionCmd->SetGuidance("In MT the stopping point, and so the result, depends");
+  precisionCmd->SetGuidance("on the order in which worker batches arrive: runs are");
+  precisionCmd->SetGuidance("not reproducible event for event.  Partial batches");
+  precisionCmd->SetGuidance("and batches after the stop are discarded, and counted.");
+  precisionCmd->SetParameterName("relErr", false);
+  precisionCmd->SetRange("relErr>=0");
+
+  estimatorsCmd = CreateCommand<G4UIcmdWithAString>("PrecisionEstimators",
+			      "Select estimators which must reach TargetPrecision");
+  estimatorsCmd->SetGuidance("Any of, separated by spaces:");
+  estimatorsCmd->SetGuidance("kid  KID energy fraction");
+  estimatorsCmd->SetGuidance("eta  KID energy fraction within 150.4 us");
+  estimatorsCmd->SetGuidance("tau  energy-weighted mean KID arrival time");
+  estimatorsCmd->SetParameterName("names", false);
+
+  batchCmd = CreateCommand<G4UIcmdWithAnInteger>("BatchSize",
+			      "Set events per batch for run length uncertainties");
+  batchCmd->SetGuidance("Each worker's last, partial batch is not used.");
+  batchCmd->SetParameterName("n", false);
+  batchCmd->SetRange("n>0");
+
+  traceRateCmd = CreateCommand<G4UIcmdWithAnInteger>("TraceRate",
+			      "Record every step of 1 in N tracks or events");
+  traceRateCmd->SetGuidance("Selection is a hash of run, event and track ID, so");
+  traceRateCmd->SetGuidance("the sample is independent of thread count.  Read at");
+  traceRateCmd->SetGuidance("the start of each run, so it can change between runs");
+  traceRateCmd->SetGuidance("but not during one.  Zero disables tracing.");
+  traceRateCmd->SetParameterName("N", false);
+  traceRateCmd->SetRange("N>=0");
+
+  traceModeCmd = CreateCommand<G4UIcmdWithAString>("TraceMode",
+			      "Sample single tracks or whole events for tracing");
+  traceModeCmd->SetCandidates("track event");
+
+  traceFileCmd = CreateCommand<G4UIcmdWithAString>("TraceFile",
+			      "Set filename for sampled trajectory output");
+  traceFileCmd->SetGuidance("{run} and {thread} are replaced by run and thread ID.");
+
+  traceBufferCmd = CreateCommand<G4UIcmdWithAnInteger>("TraceBuffer",
+			      "Set maximum traced steps held per event");
+  traceBufferCmd->SetGuidance("Further steps in the event are dropped and counted.");
+  traceBufferCmd->SetParameterName("n", false);
+  traceBufferCmd->SetRange("n>0");
+
+  heartbeatCmd = CreateCommand<G4UIcmdWithADoubleAndUnit>("HeartbeatInterval",
+			      "Set time between progress reports during a run");
+  heartbeatCmd->SetGuidance("Zero (the default) disables the heartbeat and status");
+  heartbeatCmd->SetGuidance("file entirely; e.g. 10 s gives a report every ten");
+  heartbeatCmd->SetGuidance("seconds while /run/beamOn is in progress.");
+  heartbeatCmd->SetParameterName("interval", false);
+  heartbeatCmd->SetRange("interval>=0");
+  heartbeatCmd->SetDefaultUnit("s");
+
+  statusCmd = CreateCommand<G4UIcmdWithAString>("StatusFile",
+			      "Set filename for heartbeat progress snapshots");
+  statusCmd->SetGuidance("Written only while HeartbeatInterval is non-zero.");
+
+  progressCmd = CreateCommand<G4UIcmdWithoutParameter>("Progress",
+			      "Print events, rate, live tracks, RSS and ETA");
+  progressCmd->SetGuidance("The master is blocked in /run/beamOn during a batch");
+  progressCmd->SetGuidance("run, so this reports only between runs.  Follow a");
+  progressCmd->SetGuidance("run in progress with HeartbeatInterval and StatusFile.");
 }
 
 
 PhononConfigMessenger::~PhononConfigMessenger() {
   delete hitsCmd; hitsCmd=0;
+  delete trackCmd; trackCmd=0;
+  delete formatCmd; formatCmd=0;
+  delete tallyFileCmd; tallyFileCmd=0;
+  delete tallyBinsCmd; tallyBinsCmd=0;
+  delete tallyTimeCmd; tallyTimeCmd=0;
+  delete tallyMaxCmd; tallyMaxCmd=0;
+  delete timingCmd; timingCmd=0;
+  delete allocCmd; allocCmd=0;
+  delete historyCmd; historyCmd=0;
+  delete shellsCmd; shellsCmd=0;
+  delete splitCmd; splitCmd=0;
+  delete filmCmd; filmCmd=0;
+  delete filmSamplesCmd; filmSamplesCmd=0;
+  delete mergeMaxCmd; mergeMaxCmd=0;
+  delete mergeTolCmd; mergeTolCmd=0;
+  delete mergeDistCmd; mergeDistCmd=0;
+  delete scanGridCmd; scanGridCmd=0;
+  delete scanRangeCmd; scanRangeCmd=0;
+  delete scanSpotCmd; scanSpotCmd=0;
+  delete scanFileCmd; scanFileCmd=0;
+  delete precisionCmd; precisionCmd=0;
+  delete estimatorsCmd; estimatorsCmd=0;
+  delete batchCmd; batchCmd=0;
+  delete traceRateCmd; traceRateCmd=0;
+  delete traceModeCmd; traceModeCmd=0;
+  delete traceFileCmd; traceFileCmd=0;
+  delete traceBufferCmd; traceBufferCmd=0;
+  delete heartbeatCmd; heartbeatCmd=0;
+  delete statusCmd; statusCmd=0;
+  delete progressCmd; progressCmd=0;
 }
 
 
-// Parse user input and add to configuration
+// Parse user input and add to configuration; commands are grouped by
+// topic, and each group returns true if it handled the command
 
 void PhononConfigMessenger::SetNewValue(G4UIcommand* cmd, G4String value) {
+  if (SetOutputValue(cmd, value)) return;
+  if (SetTallyValue(cmd, value)) return;
+  if (SetBiasingValue(cmd, value)) return;
+  SetRunValue(cmd, value);
+}
+
+
+namespace {
+  // "none" clears a filename
+  G4String FileName(const G4String& value) {
+    return (value == "none") ? G4String("") : value;
+  }
+
+  // Whitespace-separated words
+  std::vector<G4String> Words(const G4String& value) {
+    std::vector<G4String> words;
+    std::istringstream input(value);
+    G4String word;
+    while (input >> word) words.push_back(word);
+    return words;
+  }
+
+  // Numbers followed by an optional length unit, e.g. "1 2 3 mm"; "none"
+  // is empty.  Returns false if any other word is found.
+  G4bool Lengths(const G4String& value, std::vector<G4double>& values) {
+    values.clear();
+    G4double unit = mm;
+    for (const G4String& token : Words(FileName(value))) {
+      char* end = 0;
+      G4double v = std::strtod(token.c_str(), &end);
+      if (*end == '\0') values.push_back(v);
+      else if (G4UIcommand::CategoryOf(token.c_str()) == "Length")
+	unit = G4UIcommand::ValueOf(token);	// Trailing unit
+      else return false;
+    }
+    for (G4double& v : values) v *= unit;
+    return true;
+  }
+}
+
+
+// Output files, format and diagnostics written alongside them
+
+G4bool PhononConfigMessenger::SetOutputValue(G4UIcommand* cmd,
+					     const G4String& value) {
   if (cmd == hitsCmd) theManager->SetHitOutput(value);
+  else if (cmd == trackCmd) theManager->SetTrackingOutput(value);
+  else if (cmd == formatCmd) theManager->SetOutputFormat(value);
+  else if (cmd == historyCmd) theManager->SetHistoryFile(FileName(value));
+  else if (cmd == traceRateCmd)
+    theManager->SetTraceRate(traceRateCmd->GetNewIntValue(value));
+  else if (cmd == traceModeCmd) theManager->SetTraceMode(value);
+  else if (cmd == traceFileCmd) theManager->SetTraceFile(value);
+  else if (cmd == traceBufferCmd)
+    theManager->SetTraceBuffer(traceBufferCmd->GetNewIntValue(value));
+  else return false;
+  return true;
+}
+
+
+// Run-level tallies and profiling
+
+G4bool PhononConfigMessenger::SetTallyValue(G4UIcommand* cmd,
+					    const G4String& value) {
+  if (cmd == tallyFileCmd) theManager->SetEnergyTallyFile(FileName(value));
+  else if (cmd == tallyBinsCmd) {
+    G4int nx, ny, nz, nt;
+    std::istringstream(value) >> nx >> ny >> nz >> nt;
+    theManager->SetEnergyTallyBins(nx, ny, nz, nt);
+  }
+  else if (cmd == tallyTimeCmd)
+    theManager->SetEnergyTallyTime(tallyTimeCmd->GetNewDoubleValue(value));
+  else if (cmd == tallyMaxCmd)
+    theManager->SetEnergyTallyMaxVoxels(tallyMaxCmd->GetNewIntValue(value));
+  else if (cmd == timingCmd)
+    theManager->SetProcessTiming(timingCmd->GetNewBoolValue(value));
+  else if (cmd == allocCmd)
+    theManager->SetAllocationProfile(allocCmd->GetNewBoolValue(value));
+  else if (cmd == scanGridCmd) {
+    G4int nx, ny;
+    std::istringstream(value) >> nx >> ny;
+    theManager->SetScanGrid(nx, ny);
+  }
+  else if (cmd == scanRangeCmd) {
+    G4double xmin, xmax, ymin, ymax;
+    G4String unit;
+    std::istringstream(value) >> xmin >> xmax >> ymin >> ymax >> unit;
+    G4double scale = G4UIcommand::ValueOf(unit);
+    theManager->SetScanRange(xmin*scale, xmax*scale, ymin*scale, ymax*scale);
+  }
+  else if (cmd == scanSpotCmd)
+    theManager->SetScanSpotRadius(scanSpotCmd->GetNewDoubleValue(value));
+  else if (cmd == scanFileCmd) theManager->SetScanFile(value);
+  else return false;
+  return true;
+}
+
+
+// Variance reduction and sensor response
+
+G4bool PhononConfigMessenger::SetBiasingValue(G4UIcommand* cmd,
+					      const G4String& value) {
+  if (cmd == shellsCmd) {
+    std::vector<G4double> radii;
+    if (Lengths(value, radii)) theManager->SetImportanceShells(radii);
+    else {
+      G4ExceptionDescription msg;
+      msg << "Invalid shell radii \"" << value << "\"; expected numbers"
+	  << " followed by an optional length unit.";
+      cmd->CommandFailed(fParameterOutOfRange, msg);
+    }
+  }
+  else if (cmd == splitCmd)
+    theManager->SetSplittingFactor(splitCmd->GetNewIntValue(value));
+  else if (cmd == filmCmd) theManager->SetFilmResponse(value);
+  else if (cmd == filmSamplesCmd)
+    theManager->SetFilmTableSamples(filmSamplesCmd->GetNewIntValue(value));
+  else if (cmd == mergeMaxCmd)
+    theManager->SetMergeMaxTracks(mergeMaxCmd->GetNewIntValue(value));
+  else if (cmd == mergeTolCmd)
+    theManager->SetMergeTolerance(mergeTolCmd->GetNewDoubleValue(value));
+  else if (cmd == mergeDistCmd)
+    theManager->SetMergeDistance(mergeDistCmd->GetNewDoubleValue(value));
+  else return false;
+  return true;
+}
+
+
+// Run length and progress reporting
+
+G4bool PhononConfigMessenger::SetRunValue(G4UIcommand* cmd,
+					  const G4String& value) {
+  if (cmd == precisionCmd)
+    theManager->SetTargetPrecision(precisionCmd->GetNewDoubleValue(value));
+  else if (cmd == estimatorsCmd) theManager->SetPrecisionEstimators(Words(value));
+  else if (cmd == batchCmd)
+    theManager->SetBatchSize(batchCmd->GetNewIntValue(value));
+  else if (cmd == heartbeatCmd)
+    theManager->SetHeartbeatInterval(heartbeatCmd->GetNewDoubleValue(value));
+  else if (cmd == statusCmd) theManager->SetStatusFile(value);
+  else if (cmd == progressCmd) {
+    PhononRunProgress::Instance()->Report(G4cout);
+    G4cout << G4endl;
+  }
+  else return false;
+  return true;
 }
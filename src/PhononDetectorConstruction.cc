@@ -1,5 +1,7 @@
 #include "PhononDetectorConstruction.hh"
+#include "PhononConfigManager.hh"
 #include "PhononSensitivity.hh"
+#include "PhononTabulatedElectrode.hh"
 #include "G4CMPLogicalBorderSurface.hh"
 #include "G4CMPPhononElectrode.hh"
 #include "G4CMPSurfaceProperty.hh"
@@ -75,6 +77,24 @@ G4VPhysicalVolume* PhononDetectorConstruction::Construct()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
 
+// Sensitive detectors are thread-local, so each worker builds its own.
+// Phonons absorbed at the sensor boundaries end their step in the substrate
+
+void PhononDetectorConstruction::ConstructSDandField()
+{
+    G4SDManager* SDman = G4SDManager::GetSDMpointer();
+    G4VSensitiveDetector* sensitivity =
+        SDman->FindSensitiveDetector("PhononElectrode", false);
+    if (!sensitivity) {
+        sensitivity = new PhononSensitivity("PhononElectrode");
+        SDman->AddNewDetector(sensitivity);
+    }
+
+    SetSensitiveDetector("SiliconSubstrate", sensitivity);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo....
+
 void PhononDetectorConstruction::DefineMaterials()
 {
     G4NistManager* nist = G4NistManager::Instance();
@@ -173,6 +193,10 @@ void PhononDetectorConstruction::SetupGeometry()
         siAl->AddScatteringProperties(AnhCutoff, ReflCutoff, noAnhCoeff,
             noDiffuseCoeff, fullSpecCoeff, GHz, GHz, GHz);
 
+        // Without a film model, siAl is a perfect absorber
+        if (PhononConfigManager::GetFilmResponse() != "perfect")
+            AttachPhononSensor(siAl);
+
         siTeflon = new G4CMPSurfaceProperty("siTeflon",
             1.0, 0.0, 0.0, 0.0,   // q absorption, q refl, e min k (to absorb), hole min k
             0.0, 1.0, 1.0, 0.0);  // phonon abs, phonon refl (implying transmission), ph specular, p min k
@@ -223,6 +247,9 @@ AttachPhononSensor(G4CMPSurfaceProperty* surfProp) {
     sensorProp->AddConstProperty("subgapAbsorption", 0.1);
 
     // Attach electrode object to handle KaplanQP interface
-    surfProp->SetPhononElectrode(new G4CMPPhononElectrode);
+    if (PhononConfigManager::GetFilmResponse() == "tabulated")
+        surfProp->SetPhononElectrode(new PhononTabulatedElectrode(sensorProp));
+    else
+        surfProp->SetPhononElectrode(new G4CMPPhononElectrode);
 }
 
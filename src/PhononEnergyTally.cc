@@ -0,0 +1,211 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononEnergyTally.cc
+//
+// Description:	Time-resolved 3D voxel tally of phonon energy in the
+//		substrate, with sparse bounded per-thread storage.
+
+#include "PhononEnergyTally.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononConfigManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+
+namespace {
+  // Long ballistic steps are sampled at voxel pitch, up to this many points
+  const G4int maxSamplesPerStep = 256;
+}
+
+
+PhononEnergyTally::PhononEnergyTally(const G4String& volName,
+				     const G4String& name)
+  : PhononAccumulableT<PhononEnergyTally>(name), volumeName(volName),
+    volume(0), nBins{1,1,1,1}, tMax(0.), minPitch(0.), maxVoxels(0),
+    total(0.), overflow(0.), mergeDropped(0) {;}
+
+
+// Mesh covers the bounding box of the named volume, placed in the world
+
+void PhononEnergyTally::Configure() {
+  volume = 0;
+  if (PhononConfigManager::GetEnergyTallyFile().empty()) return;
+
+  const G4VPhysicalVolume* pv =
+    G4PhysicalVolumeStore::GetInstance()->GetVolume(volumeName, false);
+  if (!pv) {
+    G4ExceptionDescription msg;
+    msg << "Volume " << volumeName << " not found; energy tally disabled.";
+    G4Exception("PhononEnergyTally::Configure", "PhonTally001",
+		JustWarning, msg);
+    return;
+  }
+
+  pv->GetLogicalVolume()->GetSolid()->BoundingLimits(lower, upper);
+  lower += pv->GetTranslation();
+  upper += pv->GetTranslation();
+
+  const std::vector<G4int>& bins = PhononConfigManager::GetEnergyTallyBins();
+  for (size_t i=0; i<4; i++) nBins[i] = std::max(1, bins[i]);
+
+  pitch.set((upper.x()-lower.x())/nBins[0], (upper.y()-lower.y())/nBins[1],
+	    (upper.z()-lower.z())/nBins[2]);
+  minPitch = std::min({pitch.x(), pitch.y(), pitch.z()});
+  tMax = PhononConfigManager::GetEnergyTallyTime();
+  maxVoxels = PhononConfigManager::GetEnergyTallyMaxVoxels();
+
+  volume = pv;
+}
+
+
+// Spread step's energy-time product evenly along its straight path
+
+void PhononEnergyTally::Score(const G4Step* step) {
+  const G4StepPoint* prePoint = step->GetPreStepPoint();
+  if (prePoint->GetPhysicalVolume() != volume) return;
+
+  G4double dt = step->GetDeltaTime();
+  if (dt <= 0.) return;
+
+  G4double score =
+    prePoint->GetKineticEnergy() * step->GetTrack()->GetWeight() * dt;
+
+  G4int nSample = G4int(std::ceil(step->GetStepLength()/minPitch));
+  nSample = std::max(1, std::min(nSample, maxSamplesPerStep));
+
+  const G4ThreeVector& pos0 = prePoint->GetPosition();
+  G4ThreeVector dpos = step->GetPostStepPoint()->GetPosition() - pos0;
+  G4double t0 = prePoint->GetGlobalTime();
+
+  for (G4int i=0; i<nSample; i++) {
+    G4double f = (i+0.5)/nSample;
+    Add(pos0 + f*dpos, t0 + f*dt, score/nSample);
+  }
+}
+
+void PhononEnergyTally::Add(const G4ThreeVector& pos, G4double time,
+			    G4double score) {
+  total += score;
+
+  G4int ix = G4int(std::floor((pos.x()-lower.x())/pitch.x()));
+  G4int iy = G4int(std::floor((pos.y()-lower.y())/pitch.y()));
+  G4int iz = G4int(std::floor((pos.z()-lower.z())/pitch.z()));
+  G4int it = G4int(std::floor(time/tMax * nBins[3]));
+
+  // Points on the far faces belong to the last bin
+  ix = std::min(ix, nBins[0]-1);
+  iy = std::min(iy, nBins[1]-1);
+  iz = std::min(iz, nBins[2]-1);
+
+  if (ix < 0 || iy < 0 || iz < 0 || it < 0 || it >= nBins[3]) {
+    overflow += score;
+    return;
+  }
+
+  Add((((uint64_t(it)*nBins[2] + iz)*nBins[1] + iy)*nBins[0] + ix), score);
+}
+
+G4bool PhononEnergyTally::Add(uint64_t index, G4double score) {
+  auto voxel = voxels.find(index);
+  if (voxel != voxels.end()) voxel->second += score;
+  else if (voxels.size() < maxVoxels) voxels.emplace(index, score);
+  else {
+    overflow += score;
+    return false;
+  }
+  return true;
+}
+
+
+// Workers can each fill the cap with different voxels, so the master
+// copy may run out of room while merging
+
+void PhononEnergyTally::Add(const PhononEnergyTally& tally) {
+  for (const auto& voxel : tally.voxels) {
+    if (!Add(voxel.first, voxel.second)) mergeDropped++;
+  }
+  total += tally.total;
+  overflow += tally.overflow;
+}
+
+void PhononEnergyTally::Reset() {
+  voxels.clear();
+  total = overflow = 0.;
+  mergeDropped = 0;
+}
+
+
+void PhononEnergyTally::EndOfRun(G4int runID, std::ostream& os) const {
+  PhononAllocProfile::Scope phase(PhononAllocProfile::kOutput);
+
+  if (mergeDropped > 0) {
+    G4ExceptionDescription msg;
+    msg << mergeDropped << " worker voxels did not fit the " << maxVoxels
+	<< "-voxel cap when merged, and were moved to overflow.\n"
+	<< "Raise /g4cmp/EnergyTallyMaxVoxels or coarsen the binning.";
+    G4Exception("PhononEnergyTally::EndOfRun", "PhonTally002",
+		JustWarning, msg);
+  }
+
+  G4String fileName =
+    PhononConfigManager::GetOutputName(PhononConfigManager::GetEnergyTallyFile(),
+				       runID);
+
+  if (!Write(fileName)) {
+    G4ExceptionDescription msg;
+    msg << "Error writing energy tally to " << fileName;
+    G4Exception("PhononEnergyTally::EndOfRun", "PhonRun001",
+		JustWarning, msg);
+    return;
+  }
+
+  os << "Energy tally: " << voxels.size() << " voxels, "
+     << total/(eV*us) << " eV*us scored, "
+     << (total>0. ? 100.*overflow/total : 0.)
+     << "% overflow, written to " << fileName << std::endl;
+}
+
+
+// Entries are sorted by index so identical runs give identical files
+
+G4bool PhononEnergyTally::Write(const G4String& fileName) const {
+  std::ofstream out(fileName, std::ios_base::binary|std::ios_base::trunc);
+  if (!out.good()) return false;
+
+  auto put = [&out](const auto& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+
+  out.write("PHTALLY1", 8);
+  for (G4int n : nBins) put(int32_t(n));
+  put(lower.x()/mm); put(upper.x()/mm);
+  put(lower.y()/mm); put(upper.y()/mm);
+  put(lower.z()/mm); put(upper.z()/mm);
+  put(tMax/ns);
+  put(overflow/(eV*ns));
+  put(uint64_t(voxels.size()));
+
+  std::vector<std::pair<uint64_t, G4double> > sorted(voxels.begin(),
+						     voxels.end());
+  std::sort(sorted.begin(), sorted.end());
+  for (const auto& voxel : sorted) {
+    put(voxel.first);
+    put(voxel.second/(eV*ns));
+  }
+
+  return out.good();
+}
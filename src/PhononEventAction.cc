@@ -0,0 +1,75 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononEventAction.cc
+//
+// Description:	Event action for G4CMP phonon example.
+
+#include "PhononEventAction.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononBatchMonitor.hh"
+#include "PhononRunAction.hh"
+#include "PhononScanTally.hh"
+#include "PhononTrajectoryTracer.hh"
+#include "G4Event.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
+
+
+// Action is built on its own worker thread, so thread ID is ours
+
+PhononEventAction::PhononEventAction(PhononRunAction* run)
+  : G4UserEventAction(),
+    progress(PhononRunProgress::Instance()->GetCounters(G4Threading::G4GetThreadId())),
+    scanTally(run ? run->GetScanTally() : 0),
+    batchMonitor(run ? run->GetBatchMonitor() : 0),
+    tracer(run ? run->GetTracer() : 0) {;}
+
+PhononEventAction::~PhononEventAction() {;}
+
+
+// Primaries have been generated; tracking starts now
+
+void PhononEventAction::BeginOfEventAction(const G4Event*) {
+  PhononAllocProfile::SetPhase(PhononAllocProfile::kTracking);
+  if (scanTally && scanTally->IsActive()) scanTally->BeginEvent();
+}
+
+// Sensitive detectors have already seen EndOfEvent
+
+void PhononEventAction::EndOfEventAction(const G4Event* event) {
+  PhononAllocProfile::SetPhase(PhononAllocProfile::kEndOfEvent);
+
+  progress->events.fetch_add(1, std::memory_order_relaxed);
+  progress->liveTracks.store(0, std::memory_order_relaxed);
+
+  G4bool scanning = scanTally && scanTally->IsActive();
+  G4bool batching = batchMonitor && batchMonitor->IsActive();
+
+  if (scanning || batching) {
+    G4double injected = 0.;
+    for (G4int i=0; i<event->GetNumberOfPrimaryVertex(); i++) {
+      const G4PrimaryVertex* vertex = event->GetPrimaryVertex(i);
+      for (G4int j=0; j<vertex->GetNumberOfParticle(); j++) {
+	const G4PrimaryParticle* primary = vertex->GetPrimary(j);
+	injected += primary->GetKineticEnergy() * primary->GetWeight();
+      }
+    }
+
+    if (scanning) scanTally->EndEvent(event->GetEventID(), injected);
+
+    // Soft abort finishes this event; the worker then asks for no more
+    if (batching && batchMonitor->EndEvent(injected))
+      G4RunManager::GetRunManager()->AbortRun(true);
+  }
+
+  if (tracer) tracer->EndEvent();
+
+  if (PhononAllocProfile::IsEnabled()) PhononAllocProfile::EndEvent();
+  PhononAllocProfile::SetPhase(PhononAllocProfile::kOther);
+}
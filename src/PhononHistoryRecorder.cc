@@ -0,0 +1,246 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononHistoryRecorder.cc
+//
+// Description:	Wrapper which records phonon surface interactions for
+//		offline reweighting of surface probabilities.
+
+#include "PhononHistoryRecorder.hh"
+#include "G4CMPConfigManager.hh"
+#include "G4CMPGeometryUtils.hh"
+#include "G4CMPLogicalBorderSurface.hh"
+#include "G4CMPPhononTrackInfo.hh"
+#include "G4CMPSurfaceProperty.hh"
+#include "G4CMPTrackUtils.hh"
+#include "G4Event.hh"
+#include "G4EventManager.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "G4VParticleChange.hh"
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+  G4ThreadLocal PhononHistoryRecorder* threadRecorder = 0;
+
+  // Relative change in tangential wavevector still counted as specular
+  const G4double specularTolerance = 1e-6;
+
+  // Relative mismatch of secondary energies still counted as conserved
+  const G4double energyTolerance = 1e-6;
+}
+
+
+// Wrapper keeps the original name and type, so lookups still find it
+
+PhononHistoryRecorder::PhononHistoryRecorder(G4VProcess* process)
+  : G4WrapperProcess(process->GetProcessName(), process->GetProcessType()),
+    eventID(-1), trackID(0), parentID(0), startWeight(1.), startTime(0.),
+    startEnergy(0.) {
+  RegisterProcess(process);
+  SetProcessSubType(process->GetProcessSubType());
+  threadRecorder = this;
+}
+
+PhononHistoryRecorder::~PhononHistoryRecorder() {
+  if (threadRecorder == this) threadRecorder = 0;
+}
+
+PhononHistoryRecorder* PhononHistoryRecorder::GetThreadRecorder() {
+  return threadRecorder;
+}
+
+
+void PhononHistoryRecorder::SetOutputFile(const G4String& name) {
+  if (name == fileName) return;
+
+  if (fout.is_open()) fout.close();
+  fileName = name;
+  surfaceIDs.clear();		// Surfaces are defined again in each file
+
+  if (fileName.empty()) return;
+
+  fout.open(fileName, std::ios_base::binary|std::ios_base::trunc);
+  if (!fout.good()) {
+    G4ExceptionDescription msg;
+    msg << "Unable to open " << fileName << " for boundary histories.";
+    G4Exception("PhononHistoryRecorder::SetOutputFile", "PhonHist001",
+		JustWarning, msg);
+    fout.close();
+    return;
+  }
+
+  fout.write("PHNHIST2", 8);
+}
+
+void PhononHistoryRecorder::Flush() {
+  if (fout.is_open()) fout.flush();
+}
+
+
+// Interactions are collected per track and written when it ends
+
+void PhononHistoryRecorder::BeginTrack(const G4Track* track) {
+  const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  eventID = event ? event->GetEventID() : -1;
+  trackID = track->GetTrackID();
+  parentID = track->GetParentID();
+  startWeight = track->GetWeight();
+  startTime = track->GetGlobalTime();
+  startEnergy = track->GetKineticEnergy();
+  interactions.clear();
+}
+
+void PhononHistoryRecorder::EndTrack(const G4Track* track) {
+  if (!fout.is_open() || track->GetTrackID() != trackID) return;
+
+  Put('T');
+  Put<int32_t>(eventID);
+  Put<int32_t>(trackID);
+  Put<int32_t>(parentID);
+  Put<float>(startWeight);
+  Put<float>(track->GetWeight());
+  Put<float>(startTime/ns);
+  Put<float>(startEnergy/eV);
+  Put<uint32_t>(interactions.size());
+  for (const Interaction& hit : interactions) {
+    Put(hit.surface);
+    Put(hit.outcome);
+    Put(hit.energy);
+    Put(hit.time);
+    for (float prob : hit.prob) Put(prob);
+  }
+
+  interactions.clear();
+}
+
+
+// Boundary steps are classified after the wrapped process has acted;
+// the wavevector and reflection count in the track info are updated in
+// place by reflection, so they and the probabilities are taken first.
+// Past the bounce limit G4CMP absorbs as usual, but kills any phonon
+// which would otherwise reflect or transmit, without a deposit.
+
+G4VParticleChange*
+PhononHistoryRecorder::PostStepDoIt(const G4Track& track, const G4Step& step) {
+  const G4StepPoint* postPoint = step.GetPostStepPoint();
+  if (!fout.is_open() || postPoint->GetStepStatus() != fGeomBoundary)
+    return G4WrapperProcess::PostStepDoIt(track, step);
+
+  const G4CMPLogicalBorderSurface* border =
+    G4CMPLogicalBorderSurface::GetSurface(step.GetPreStepPoint()->GetPhysicalVolume(),
+					  postPoint->GetPhysicalVolume());
+  if (!border || track.GetTrackID() != trackID)
+    return G4WrapperProcess::PostStepDoIt(track, step);
+
+  auto* trackInfo = G4CMP::GetTrackInfo<G4CMPPhononTrackInfo>(track);
+  G4ThreeVector kIn = trackInfo->k();
+  G4int maxBounces = G4CMPConfigManager::GetMaxPhononBounces();
+  G4bool atLimit = (maxBounces >= 0 && trackInfo->ReflectionCount() >= maxBounces);
+  G4double energy = track.GetKineticEnergy();
+  G4double time = track.GetGlobalTime();
+
+  Interaction hit = { GetSurfaceID(border), kKilled, float(energy/eV),
+		      float(time/ns), {} };
+  GetProbabilities(border, energy, hit.prob);
+
+  G4VParticleChange* change = G4WrapperProcess::PostStepDoIt(track, step);
+
+  Outcome outcome = kKilled;
+  if (change->GetTrackStatus() != fAlive) {
+    if (IsDownconversion(change, energy)) outcome = kDownconverted;
+    else if (atLimit && change->GetNumberOfSecondaries() == 0 &&
+	     change->GetNonIonizingEnergyDeposit() <= 0.) outcome = kBounceLimit;
+  } else {
+    G4ThreeVector normal = G4CMP::GetSurfaceNormal(step);
+    G4ThreeVector dk = trackInfo->k() - kIn;
+    G4ThreeVector dkTangent = dk - dk.dot(normal)*normal;
+    outcome = (dkTangent.mag() <= specularTolerance*kIn.mag())
+      ? kSpecular : kDiffuse;
+  }
+
+  hit.outcome = outcome;
+  interactions.push_back(hit);
+  return change;
+}
+
+
+// Same inputs, and normalization of the reflection modes, as
+// G4CMPPhononBoundaryProcess uses to choose an outcome
+
+void PhononHistoryRecorder::
+GetProbabilities(const G4CMPLogicalBorderSurface* border, G4double energy,
+		 float prob[5]) const {
+  auto* surfProp =
+    dynamic_cast<const G4CMPSurfaceProperty*>(border->GetSurfaceProperty());
+  if (!surfProp) {		// Plain reflection
+    prob[0] = 0.; prob[1] = 1.; prob[2] = 0.; prob[3] = 1.; prob[4] = 0.;
+    return;
+  }
+
+  G4double freq = energy/h_Planck;
+  G4double anh = surfProp->AnharmonicReflProb(freq);
+  G4double spec = surfProp->SpecularReflProb(freq);
+  G4double diff = surfProp->DiffuseReflProb(freq);
+  G4double norm = anh + spec + diff;
+  if (norm <= 0.) { anh = diff = 0.; spec = norm = 1.; }
+
+  prob[0] = surfProp->GetPhononAbsProb();
+  prob[1] = surfProp->GetPhononReflProb();
+  prob[2] = anh/norm;
+  prob[3] = spec/norm;
+  prob[4] = diff/norm;
+}
+
+// Absorption by an electrode film may also re-emit phonons, but not
+// all of the energy, and deposits the rest
+
+G4bool PhononHistoryRecorder::IsDownconversion(const G4VParticleChange* change,
+					      G4double energy) {
+  if (change->GetNumberOfSecondaries() != 2 ||
+      change->GetLocalEnergyDeposit() > 0. ||
+      change->GetNonIonizingEnergyDeposit() > 0.) return false;
+
+  G4double eSecondaries = 0.;
+  for (G4int i=0; i<2; i++)
+    eSecondaries += change->GetSecondary(i)->GetKineticEnergy();
+
+  return std::fabs(eSecondaries-energy) <= energyTolerance*energy;
+}
+
+
+// Surface names are written once per file
+
+uint16_t
+PhononHistoryRecorder::GetSurfaceID(const G4CMPLogicalBorderSurface* border) {
+  auto found = surfaceIDs.find(border);
+  if (found != surfaceIDs.end()) return found->second;
+
+  uint16_t id = surfaceIDs.size();
+  surfaceIDs[border] = id;
+
+  auto* surfProp =
+    dynamic_cast<const G4CMPSurfaceProperty*>(border->GetSurfaceProperty());
+
+  const G4String& name = border->GetName();
+  G4String propName = surfProp ? surfProp->GetName() : G4String("unknown");
+  uint8_t nameLen = std::min<size_t>(name.size(), 255);
+  uint8_t propLen = std::min<size_t>(propName.size(), 255);
+
+  Put('S');
+  Put(id);
+  Put(nameLen);
+  fout.write(name.data(), nameLen);
+  Put(propLen);
+  fout.write(propName.data(), propLen);
+
+  return id;
+}
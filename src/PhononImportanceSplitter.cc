@@ -0,0 +1,201 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononImportanceSplitter.cc
+//
+// Description:	Geometric importance splitting of phonons toward the KID.
+
+#include "PhononImportanceSplitter.hh"
+#include "PhononConfigManager.hh"
+#include "PhononSplittingProcess.hh"
+#include "G4CMPPhononTrackInfo.hh"
+#include "G4CMPSecondaryUtils.hh"
+#include "G4CMPTrackUtils.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ParticleChange.hh"
+#include "G4PhononLong.hh"
+#include "G4PhononPolarization.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4WrapperProcess.hh"
+#include "Randomize.hh"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <ostream>
+
+
+namespace {
+  G4ThreadLocal PhononImportanceSplitter* threadSplitter = 0;
+
+  // PhononPhysicsList adds the process only if shells were set at startup,
+  // and may have wrapped it for timing
+  G4bool HasSplittingProcess() {
+    G4ProcessManager* pm = G4PhononLong::Definition()->GetProcessManager();
+    G4ProcessVector* plist = pm ? pm->GetProcessList() : 0;
+    for (size_t i=0; plist && i<plist->size(); i++) {
+      const G4VProcess* proc = (*plist)[i];
+      while (const G4WrapperProcess* wrapper =
+	     dynamic_cast<const G4WrapperProcess*>(proc))
+	proc = wrapper->GetRegisteredProcess();
+      if (dynamic_cast<const PhononSplittingProcess*>(proc)) return true;
+    }
+    return false;
+  }
+}
+
+PhononImportanceSplitter::
+PhononImportanceSplitter(const G4String& substrate, const G4String& sensor,
+			 const G4String& name)
+  : PhononAccumulableT<PhononImportanceSplitter>(name),
+    substrateName(substrate), sensorName(sensor), substrate(0),
+    sensorHalfX(0.), sensorHalfY(0.), factor(2), nSplit(0), nCopies(0),
+    nRouletteKilled(0), nRouletteSurvived(0) {
+  threadSplitter = this;
+}
+
+PhononImportanceSplitter::~PhononImportanceSplitter() {
+  if (threadSplitter == this) threadSplitter = 0;
+}
+
+PhononImportanceSplitter* PhononImportanceSplitter::GetThreadSplitter() {
+  return threadSplitter;
+}
+
+
+void PhononImportanceSplitter::Configure() {
+  substrate = 0;
+
+  radii = PhononConfigManager::GetImportanceShells();
+  factor = PhononConfigManager::GetSplittingFactor();
+  if (radii.empty() || factor < 2) return;
+
+  if (!HasSplittingProcess()) {
+    G4ExceptionDescription msg;
+    msg << "Importance shells were set after /run/initialize; splitting"
+	<< " disabled.  Set /g4cmp/ImportanceShells before initializing.";
+    G4Exception("PhononImportanceSplitter::Configure", "PhonSplit002",
+		JustWarning, msg);
+    return;
+  }
+
+  std::sort(radii.begin(), radii.end(), std::greater<G4double>());
+
+  G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+  const G4VPhysicalVolume* sensor = store->GetVolume(sensorName, false);
+  const G4VPhysicalVolume* slab = store->GetVolume(substrateName, false);
+  if (!sensor || !slab) {
+    G4ExceptionDescription msg;
+    msg << "Volume " << (sensor ? substrateName : sensorName)
+	<< " not found; importance splitting disabled.";
+    G4Exception("PhononImportanceSplitter::Configure", "PhonSplit001",
+		JustWarning, msg);
+    return;
+  }
+
+  G4ThreeVector lower, upper;
+  sensor->GetLogicalVolume()->GetSolid()->BoundingLimits(lower, upper);
+  sensorCenter = sensor->GetTranslation() + 0.5*(lower+upper);
+  sensorHalfX = 0.5*(upper.x()-lower.x());
+  sensorHalfY = 0.5*(upper.y()-lower.y());
+
+  substrate = slab;
+}
+
+
+// Number of shells containing position (0 = outside all, least important)
+
+G4int PhononImportanceSplitter::GetShell(const G4ThreeVector& pos) const {
+  G4double dx = std::max(std::fabs(pos.x()-sensorCenter.x()) - sensorHalfX, 0.);
+  G4double dy = std::max(std::fabs(pos.y()-sensorCenter.y()) - sensorHalfY, 0.);
+  G4double dist = std::hypot(dx, dy);
+
+  G4int shell = 0;
+  while (shell < G4int(radii.size()) && dist < radii[shell]) shell++;
+  return shell;
+}
+
+
+// Only live tracks which stay in the substrate are split or rouletted.
+// Copies are placed on the substrate side of any boundary just crossed.
+
+void PhononImportanceSplitter::Apply(const G4Step& step,
+				     G4ParticleChange& change) {
+  const G4StepPoint* prePoint = step.GetPreStepPoint();
+  const G4StepPoint* postPoint = step.GetPostStepPoint();
+  const G4Track* track = step.GetTrack();
+
+  if (prePoint->GetPhysicalVolume() != substrate ||
+      track->GetTrackStatus() != fAlive) return;
+
+  G4int shells = GetShell(postPoint->GetPosition())
+    - GetShell(prePoint->GetPosition());
+  if (shells == 0) return;
+
+  G4double ratio = std::pow(G4double(factor), shells);
+  G4double weight = track->GetWeight();
+
+  if (ratio < 1.) {		// Moving away from KID: Russian roulette
+    if (G4UniformRand() < ratio) {
+      change.ProposeWeight(weight/ratio);
+      nRouletteSurvived++;
+    } else {
+      change.ProposeTrackStatus(fStopAndKill);
+      nRouletteKilled++;
+    }
+    return;
+  }
+
+  G4ThreeVector pos = postPoint->GetPosition();
+  if (postPoint->GetStepStatus() == fGeomBoundary) {
+    pos -= std::min(1.*nm, 0.5*step.GetStepLength())
+      * prePoint->GetMomentumDirection();
+  }
+
+  G4int nCopy = G4int(ratio + 0.5);
+  G4int mode = G4PhononPolarization::Get(track->GetParticleDefinition());
+  const G4ThreeVector& waveVec =
+    G4CMP::GetTrackInfo<G4CMPPhononTrackInfo>(*track)->k();
+
+  // Without this, AddSecondary() gives every copy the parent's weight
+  change.SetSecondaryWeightByProcess(true);
+  change.ProposeWeight(weight/nCopy);
+  change.SetNumberOfSecondaries(nCopy-1);
+  for (G4int i=1; i<nCopy; i++) {
+    G4Track* copy = G4CMP::CreatePhonon(prePoint->GetTouchable(), mode,
+					waveVec, track->GetKineticEnergy(),
+					postPoint->GetGlobalTime(), pos);
+    copy->SetWeight(weight/nCopy);
+    change.AddSecondary(copy);
+  }
+
+  nSplit++;
+  nCopies += nCopy-1;
+}
+
+
+void PhononImportanceSplitter::Add(const PhononImportanceSplitter& splitter) {
+  nSplit += splitter.nSplit;
+  nCopies += splitter.nCopies;
+  nRouletteKilled += splitter.nRouletteKilled;
+  nRouletteSurvived += splitter.nRouletteSurvived;
+}
+
+void PhononImportanceSplitter::Reset() {
+  nSplit = nCopies = nRouletteKilled = nRouletteSurvived = 0;
+}
+
+void PhononImportanceSplitter::EndOfRun(G4int, std::ostream& os) const {
+  os << "Importance splitting: " << nSplit << " splits (" << nCopies
+     << " copies), roulette " << nRouletteSurvived << " survived / "
+     << nRouletteKilled << " killed" << std::endl;
+}
@@ -0,0 +1,218 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononMacroMerger.cc
+//
+// Description:	Merging of downconversion secondaries into weighted
+//		macro-phonons.
+
+#include "PhononMacroMerger.hh"
+#include "PhononConfigManager.hh"
+#include "G4CMPPhononTrackInfo.hh"
+#include "G4CMPSecondaryUtils.hh"
+#include "G4CMPTrackUtils.hh"
+#include "G4PhononPolarization.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <ostream>
+
+
+namespace {
+  // Cells grow by 2^n, n < maxCoarsening, to bring a stage under the cap
+  const G4int maxCoarsening = 8;
+
+  typedef std::array<G4long, 8> CellKey;	// mode, log E, x, y, z, dir
+
+  // Stages left over the cap are warned about once per run, on any thread
+  std::atomic<G4bool> overCapWarned(false);
+}
+
+
+PhononMacroMerger::PhononMacroMerger(const G4String& name)
+  : PhononAccumulableT<PhononMacroMerger>(name), maxTracks(0), tolerance(0.), distance(0.),
+    nStages(0), nCoarsened(0), nOverCap(0), maxScale(0.), nMerged(0),
+    nMacro(0), energy(0.), energySpread(0.), displacement(0.), angle(0.),
+    residual(0.) {;}
+
+
+void PhononMacroMerger::Configure() {
+  maxTracks = std::max(PhononConfigManager::GetMergeMaxTracks(), 0);
+  tolerance = PhononConfigManager::GetMergeTolerance();
+  distance = PhononConfigManager::GetMergeDistance();
+
+  // Master starts its run before the workers
+  if (G4Threading::IsMasterThread()) overCapWarned = false;
+}
+
+G4bool PhononMacroMerger::IsCandidate(const G4Track* track) const {
+  const G4VProcess* creator = track->GetCreatorProcess();
+  return (creator && creator->GetProcessName() == "phononDownconversion");
+}
+
+
+// Group candidates into cells, coarsening until the cap is met or the
+// largest cells are reached
+
+G4bool PhononMacroMerger::
+MergeStage(const std::vector<const G4Track*>& stage,
+	   std::unordered_set<const G4Track*>& discard,
+	   std::vector<G4Track*>& macros) {
+  std::vector<const G4Track*> candidates;
+  for (const G4Track* track : stage) {
+    if (IsCandidate(track)) candidates.push_back(track);
+  }
+
+  if (candidates.size() <= maxTracks) return false;
+
+  std::map<CellKey, std::vector<const G4Track*> > cells;
+  G4double scale = 1.;
+  for (G4int pass=1; ; pass++, scale*=2.) {
+    G4double eWidth = std::log1p(tolerance*scale);
+    G4double dirWidth = tolerance*scale;
+    G4double xWidth = distance*scale;
+
+    cells.clear();
+    for (const G4Track* track : candidates) {
+      const G4ThreeVector& pos = track->GetPosition();
+      const G4ThreeVector& dir = track->GetMomentumDirection();
+
+      CellKey key = {{
+	G4PhononPolarization::Get(track->GetParticleDefinition()),
+	G4long(std::floor(std::log(track->GetKineticEnergy()/eV)/eWidth)),
+	G4long(std::floor(pos.x()/xWidth)),
+	G4long(std::floor(pos.y()/xWidth)),
+	G4long(std::floor(pos.z()/xWidth)),
+	G4long(std::floor((dir.x()+1.)/dirWidth)),
+	G4long(std::floor((dir.y()+1.)/dirWidth)),
+	G4long(std::floor((dir.z()+1.)/dirWidth)) }};
+      cells[key].push_back(track);
+    }
+
+    if (cells.size() <= maxTracks || pass == maxCoarsening) break;
+  }
+
+  nStages++;
+  if (scale > 1.) nCoarsened++;
+  maxScale = std::max(maxScale, scale);
+
+  if (cells.size() > maxTracks) {
+    nOverCap++;
+    if (!overCapWarned.exchange(true)) {
+      G4ExceptionDescription msg;
+      msg << candidates.size() << " downconversion phonons still form "
+	  << cells.size() << " cells, over the cap of " << maxTracks
+	  << ", at the largest cells (tolerance " << tolerance*scale
+	  << ", distance " << distance*scale/um << " um).\n"
+	  << "Further occurrences in this run are counted in the summary.";
+      G4Exception("PhononMacroMerger::MergeStage", "PhonMerge001",
+		  JustWarning, msg);
+    }
+  }
+
+  for (const auto& cell : cells) {
+    if (cell.second.size() > 1)
+      macros.push_back(MergeCell(cell.second, discard));
+  }
+
+  return !discard.empty();
+}
+
+
+// The macro-phonon is a new track rather than a modified member, so
+// that its energy, wavevector and velocity agree
+
+G4Track* PhononMacroMerger::
+MergeCell(const std::vector<const G4Track*>& cell,
+	  std::unordered_set<const G4Track*>& discard) {
+  auto weightedEnergy = [](const G4Track* track) {
+    return track->GetWeight() * track->GetKineticEnergy();
+  };
+
+  const G4Track* keep = *std::max_element(cell.begin(), cell.end(),
+	  [&](const G4Track* a, const G4Track* b) {
+	    return weightedEnergy(a) < weightedEnergy(b);
+	  });
+
+  G4double sumW = 0., sumWE = 0.;
+  for (const G4Track* track : cell) {
+    sumW += track->GetWeight();
+    sumWE += weightedEnergy(track);
+  }
+  G4double eMacro = sumWE/sumW;
+
+  for (const G4Track* track : cell) {
+    G4double wE = weightedEnergy(track);
+    energySpread += track->GetWeight()*std::fabs(track->GetKineticEnergy()-eMacro);
+    displacement += wE*(track->GetPosition()-keep->GetPosition()).mag();
+    angle += wE*track->GetMomentumDirection().angle(keep->GetMomentumDirection());
+    discard.insert(track);
+  }
+
+  G4Track* macro = G4CMP::CreatePhonon(keep->GetTouchable(),
+	G4PhononPolarization::Get(keep->GetParticleDefinition()),
+	G4CMP::GetTrackInfo<G4CMPPhononTrackInfo>(*keep)->k(),
+	eMacro, keep->GetGlobalTime(), keep->GetPosition());
+  macro->SetWeight(sumW);
+  macro->SetParentID(keep->GetParentID());
+  macro->SetCreatorProcess(keep->GetCreatorProcess());
+
+  residual += std::fabs(macro->GetWeight()*macro->GetKineticEnergy() - sumWE);
+  energy += sumWE;
+  nMerged += cell.size()-1;
+  nMacro++;
+
+  return macro;
+}
+
+
+void PhononMacroMerger::Add(const PhononMacroMerger& merger) {
+  nStages += merger.nStages;
+  nCoarsened += merger.nCoarsened;
+  nOverCap += merger.nOverCap;
+  maxScale = std::max(maxScale, merger.maxScale);
+  nMerged += merger.nMerged;
+  nMacro += merger.nMacro;
+  energy += merger.energy;
+  energySpread += merger.energySpread;
+  displacement += merger.displacement;
+  angle += merger.angle;
+  residual += merger.residual;
+}
+
+void PhononMacroMerger::Reset() {
+  nStages = nCoarsened = nOverCap = nMerged = nMacro = 0;
+  maxScale = energy = energySpread = displacement = angle = residual = 0.;
+}
+
+
+// Errors are averaged over merged energy
+
+void PhononMacroMerger::EndOfRun(G4int, std::ostream& os) const {
+  if (nStages == 0) return;
+
+  G4double norm = (energy > 0.) ? 1./energy : 0.;
+
+  os << "Macro-phonon merging: " << nStages << " generations ("
+     << nCoarsened << " coarsened), " << nMerged << " phonons folded into "
+     << nMacro << " macro-phonons\n"
+     << "  largest cells used: tolerance " << tolerance*maxScale
+     << ", distance " << distance*maxScale/um << " um\n";
+  if (nOverCap > 0) {
+    os << "  " << nOverCap << " generations still over the cap of "
+       << maxTracks << " at the largest cells\n";
+  }
+  os << "  merging error: energy spread " << 100.*energySpread*norm
+     << "%, displacement " << displacement*norm/um << " um, direction "
+     << angle*norm/mrad << " mrad, energy residual " << residual/eV
+     << " eV" << std::endl;
+}
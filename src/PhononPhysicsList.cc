@@ -1,9 +1,21 @@
 // file: src/PhononPhysicsList.cc
 
 #include "PhononPhysicsList.hh"
+#include "PhononConfigManager.hh"
+#include "PhononHistoryRecorder.hh"
+#include "PhononSplittingProcess.hh"
+#include "PhononTimedProcess.hh"
+#include "G4CMPPhononBoundaryProcess.hh"
 #include "G4CMPPhysics.hh"        
 //#include "G4EmStandardPhysics.hh" 
+#include "G4PhononLong.hh"
+#include "G4PhononTransFast.hh"
+#include "G4PhononTransSlow.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
 #include "G4SystemOfUnits.hh"
+#include <map>
+#include <vector>
 
 PhononPhysicsList::PhononPhysicsList(G4int verbose) : G4VModularPhysicsList() {
 	SetVerboseLevel(verbose);
@@ -18,6 +30,117 @@ PhononPhysicsList::PhononPhysicsList(G4int verbose) : G4VModularPhysicsList() {
 
 PhononPhysicsList::~PhononPhysicsList() {}
 
+// Called on master and again on each worker, which owns its own processes
+
+void PhononPhysicsList::ConstructProcess() {
+	G4VModularPhysicsList::ConstructProcess();
+	if (!PhononConfigManager::GetImportanceShells().empty()) AddImportanceSplitting();
+
+	// Timing wrappers go outside, so recording is included in the time
+	if (!PhononConfigManager::GetHistoryFile().empty()) RecordBoundaryHistories();
+	if (PhononConfigManager::GetProcessTiming()) WrapPhononProcesses();
+}
+
+// Splitting is installed only if shells are set before initialization;
+// they may then be changed or cleared between runs.  One process is
+// shared by the three phonon modes, as G4CMPPhysics does for its own.
+
+void PhononPhysicsList::AddImportanceSplitting() {
+	const std::vector<G4ParticleDefinition*> phonons = {
+		G4PhononLong::Definition(), G4PhononTransFast::Definition(),
+		G4PhononTransSlow::Definition() };
+
+	PhononSplittingProcess* splitting = new PhononSplittingProcess;
+	for (G4ParticleDefinition* phonon : phonons) {
+		G4ProcessManager* pm = phonon->GetProcessManager();
+		if (pm) pm->AddDiscreteProcess(splitting);
+	}
+}
+
+// Swap the phonon boundary process for a history recorder, in the same
+// way as the timing wrappers below.  G4CMPPhysics shares one boundary
+// process between the phonon modes, so each thread has one recorder.
+
+void PhononPhysicsList::RecordBoundaryHistories() {
+	const std::vector<G4ParticleDefinition*> phonons = {
+		G4PhononLong::Definition(), G4PhononTransFast::Definition(),
+		G4PhononTransSlow::Definition() };
+
+	std::map<G4VProcess*, PhononHistoryRecorder*> recorders;
+
+	for (G4ParticleDefinition* phonon : phonons) {
+		G4ProcessManager* pm = phonon->GetProcessManager();
+		if (!pm) continue;
+
+		G4ProcessVector* plist = pm->GetProcessList();
+		std::vector<G4VProcess*> procs;
+		for (size_t i=0; i<plist->size(); i++) procs.push_back((*plist)[i]);
+
+		for (G4VProcess* proc : procs) {
+			if (!dynamic_cast<G4CMPPhononBoundaryProcess*>(proc)) continue;
+
+			G4int ordAtRest = pm->GetProcessOrdering(proc, idxAtRest);
+			G4int ordAlong = pm->GetProcessOrdering(proc, idxAlongStep);
+			G4int ordPost = pm->GetProcessOrdering(proc, idxPostStep);
+			G4bool active = pm->GetProcessActivation(proc);
+
+			PhononHistoryRecorder*& recorder = recorders[proc];
+			if (!recorder) recorder = new PhononHistoryRecorder(proc);
+
+			pm->RemoveProcess(proc);
+			pm->AddProcess(recorder, ordAtRest, ordAlong, ordPost);
+			if (!active) pm->SetProcessActivation(recorder, false);
+		}
+	}
+
+	if (verboseLevel) {
+		G4cout << "PhononPhysicsList: recording boundary histories with "
+			<< recorders.size() << " recorder(s)" << G4endl;
+	}
+}
+
+// Swap each non-transport phonon process for a timing wrapper, keeping
+// its DoIt ordering and activation. Processes shared between the three
+// phonon modes get a single wrapper, so each is deleted only once.
+
+void PhononPhysicsList::WrapPhononProcesses() {
+	const std::vector<G4ParticleDefinition*> phonons = {
+		G4PhononLong::Definition(), G4PhononTransFast::Definition(),
+		G4PhononTransSlow::Definition() };
+
+	std::map<G4VProcess*, PhononTimedProcess*> wrappers;
+
+	for (G4ParticleDefinition* phonon : phonons) {
+		G4ProcessManager* pm = phonon->GetProcessManager();
+		if (!pm) continue;
+
+		G4ProcessVector* plist = pm->GetProcessList();
+		std::vector<G4VProcess*> procs;
+		for (size_t i=0; i<plist->size(); i++) procs.push_back((*plist)[i]);
+
+		for (G4VProcess* proc : procs) {
+			if (proc->GetProcessType() == fTransportation) continue;
+
+			G4int ordAtRest = pm->GetProcessOrdering(proc, idxAtRest);
+			G4int ordAlong = pm->GetProcessOrdering(proc, idxAlongStep);
+			G4int ordPost = pm->GetProcessOrdering(proc, idxPostStep);
+			G4bool active = pm->GetProcessActivation(proc);
+
+			PhononTimedProcess*& wrapper = wrappers[proc];
+			if (!wrapper) wrapper = new PhononTimedProcess(proc);
+
+			pm->RemoveProcess(proc);
+			pm->AddProcess(wrapper, ordAtRest, ordAlong, ordPost);
+			if (!active) pm->SetProcessActivation(wrapper, false);
+		}
+	}
+
+	if (verboseLevel) {
+		G4cout << "PhononPhysicsList: timing " << wrappers.size()
+			<< " phonon processes" << G4endl;
+	}
+}
+
 void PhononPhysicsList::SetCuts() {
 	SetCutsWithDefault();
 }
\ No newline at end of file
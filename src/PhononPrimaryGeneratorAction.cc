@@ -1,4 +1,6 @@
 #include "PhononPrimaryGeneratorAction.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononConfigManager.hh"
 
 #include "G4Event.hh"
 #include "G4Geantino.hh"
@@ -23,6 +25,8 @@ PhononPrimaryGeneratorAction::~PhononPrimaryGeneratorAction() {
 }
 
 void PhononPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent) {
+    PhononAllocProfile::SetPhase(PhononAllocProfile::kGeneration);
+
     if (fParticleGun->GetParticleDefinition() == G4Geantino::Definition()) {
         G4double selector = G4UniformRand();
         if (selector < 0.531) {
@@ -36,16 +40,24 @@ void PhononPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent) {
         }
     }
 
-    const G4double RInjection = 2.33 * mm;
+    G4double RInjection = 2.33 * mm;
+    G4ThreeVector center(0., -6. * mm, 0.);
     // 1 micron inside, as in the paper
     const G4double zBack = -0.189 * mm;
 
+    // Scan mode: event N goes to grid point N % nPoints (see PhononScanTally)
+    G4int nPoints = PhononConfigManager::GetScanPoints();
+    if (nPoints > 0) {
+        RInjection = PhononConfigManager::GetScanSpotRadius();
+        center = PhononConfigManager::GetScanPosition(anEvent->GetEventID() % nPoints);
+    }
+
     G4double r = RInjection * std::sqrt(G4UniformRand());
     G4double phi = 2. * CLHEP::pi * G4UniformRand();
     G4double x = r * std::cos(phi);
     G4double y = r * std::sin(phi);
 
-    fParticleGun->SetParticlePosition(G4ThreeVector(x, y - 6. * mm, zBack));
+    fParticleGun->SetParticlePosition(G4ThreeVector(center.x() + x, center.y() + y, zBack));
     fParticleGun->SetParticleMomentumDirection(G4RandomDirection());
     fParticleGun->GeneratePrimaryVertex(anEvent);
 }
@@ -0,0 +1,84 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononProcessTiming.cc
+//
+// Description:	Run-level accumulable of per-process call counts and CPU
+//		time for the phonon example.
+
+#include "PhononProcessTiming.hh"
+#include "PhononTimedProcess.hh"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+
+PhononProcessTiming::PhononProcessTiming(const G4String& name)
+  : G4VAccumulable(name) {;}
+
+
+// Same process may be wrapped more than once; entries add by name
+
+void PhononProcessTiming::Collect() {
+  for (const PhononTimedProcess* proc : PhononTimedProcess::GetThreadProcesses()) {
+    Timing& entry = timing[proc->GetProcessName()];
+    entry.lengthCalls += proc->GetLengthCalls();
+    entry.doItCalls += proc->GetDoItCalls();
+    entry.lengthTime += proc->GetLengthTime();
+    entry.doItTime += proc->GetDoItTime();
+  }
+}
+
+void PhononProcessTiming::Merge(const G4VAccumulable& other) {
+  for (const auto& proc : static_cast<const PhononProcessTiming&>(other).timing) {
+    Timing& entry = timing[proc.first];
+    entry.lengthCalls += proc.second.lengthCalls;
+    entry.doItCalls += proc.second.doItCalls;
+    entry.lengthTime += proc.second.lengthTime;
+    entry.doItTime += proc.second.doItTime;
+  }
+}
+
+void PhononProcessTiming::Reset() {
+  timing.clear();
+  for (PhononTimedProcess* proc : PhononTimedProcess::GetThreadProcesses())
+    proc->ResetTimers();
+}
+
+
+// Table sorted by total time, most expensive process first
+
+void PhononProcessTiming::Report(std::ostream& os) const {
+  std::vector<std::pair<G4String, Timing> > rows(timing.begin(), timing.end());
+  auto totalTime = [](const Timing& t) { return t.lengthTime + t.doItTime; };
+  std::sort(rows.begin(), rows.end(), [&](const auto& a, const auto& b) {
+    return totalTime(a.second) > totalTime(b.second);
+  });
+
+  G4double sum = 0.;
+  for (const auto& row : rows) sum += totalTime(row.second);
+
+  os << "Process CPU time, summed over threads (GPIL = PostStep"
+     << "GetPhysicalInteractionLength)\n"
+     << std::setw(28) << std::left << "process" << std::right
+     << std::setw(14) << "GPIL calls" << std::setw(12) << "GPIL [s]"
+     << std::setw(14) << "DoIt calls" << std::setw(12) << "DoIt [s]"
+     << std::setw(9) << "share" << '\n';
+
+  for (const auto& row : rows) {
+    const Timing& t = row.second;
+    os << std::setw(28) << std::left << row.first << std::right
+       << std::setw(14) << t.lengthCalls
+       << std::setw(12) << std::fixed << std::setprecision(3) << t.lengthTime
+       << std::setw(14) << t.doItCalls
+       << std::setw(12) << t.doItTime
+       << std::setw(8) << std::setprecision(1)
+       << (sum > 0. ? 100.*totalTime(t)/sum : 0.) << '%' << '\n';
+  }
+  os << std::defaultfloat;
+}
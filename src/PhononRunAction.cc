@@ -0,0 +1,134 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononRunAction.cc
+//
+// Description:	Run action for G4CMP phonon example.
+
+#include "PhononRunAction.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononConfigManager.hh"
+#include "PhononHistoryRecorder.hh"
+#include "PhononRunLength.hh"
+#include "PhononRunProgress.hh"
+#include "PhononSensitivity.hh"
+#include "PhononStackingAction.hh"
+#include "PhononSteppingAction.hh"
+#include "G4AccumulableManager.hh"
+#include "G4Run.hh"
+#include "G4SDManager.hh"
+
+
+// Accumulables must be registered in the same order on every thread
+
+PhononRunAction::PhononRunAction(PhononSteppingAction* stepping,
+				 PhononStackingAction* stacking)
+  : G4UserRunAction(), steppingAction(stepping),
+    energyTally("SiliconSubstrate"), splitter("SiliconSubstrate", "KID"),
+    tallies({ &energyTally, &splitter, &macroMerger, &scanTally }) {
+  G4AccumulableManager* accumulables = G4AccumulableManager::Instance();
+  accumulables->RegisterAccumulable(&processTiming);
+  for (PhononAccumulable* tally : tallies)
+    accumulables->RegisterAccumulable(tally);
+
+  if (steppingAction) {
+    steppingAction->SetEnergyTally(&energyTally);
+    steppingAction->SetScanTally(&scanTally);
+    steppingAction->SetBatchMonitor(&batchMonitor);
+    steppingAction->SetTracer(&tracer);
+  }
+
+  if (stacking) stacking->SetMacroMerger(&macroMerger);
+}
+
+PhononRunAction::~PhononRunAction() {;}
+
+
+void PhononRunAction::BeginOfRunAction(const G4Run* run) {
+  G4AccumulableManager::Instance()->Reset();
+
+  PhononAllocProfile* allocProfile = PhononAllocProfile::Instance();
+  if (IsMaster())
+    allocProfile->BeginRun(PhononConfigManager::GetAllocationProfile());
+  allocProfile->RegisterThread();
+
+  for (PhononAccumulable* tally : tallies) tally->Configure();
+
+  // Master sets the stopping target before workers start their runs
+  if (IsMaster()) PhononRunLength::Instance()->BeginRun();
+  batchMonitor.Configure();
+
+  if (steppingAction) OpenOutputFiles(run->GetRunID());
+
+  if (IsMaster()) {
+    G4String statusFile =
+      PhononConfigManager::GetOutputName(PhononConfigManager::GetStatusFile(),
+					 run->GetRunID());
+
+    PhononRunProgress::Instance()->BeginRun(run->GetRunID(),
+					    run->GetNumberOfEventToBeProcessed(),
+				PhononConfigManager::GetHeartbeatInterval(),
+					    statusFile);
+  }
+}
+
+void PhononRunAction::EndOfRunAction(const G4Run* run) {
+  processTiming.Collect();
+  batchMonitor.EndOfRun();		// Workers finish before master
+
+  PhononHistoryRecorder* recorder = PhononHistoryRecorder::GetThreadRecorder();
+  if (recorder) recorder->Flush();
+  tracer.Close();
+  G4AccumulableManager::Instance()->Merge();	// Workers into master
+
+  if (IsMaster()) {
+    PhononRunProgress* progress = PhononRunProgress::Instance();
+    progress->EndRun();
+
+    G4cout << "---> End of run summary" << G4endl;
+    progress->Report(G4cout);
+    G4cout << G4endl;
+
+    if (!processTiming.IsEmpty()) processTiming.Report(G4cout);
+    for (const PhononAccumulable* tally : tallies) {
+      if (tally->IsActive()) tally->EndOfRun(run->GetRunID(), G4cout);
+    }
+    if (PhononAllocProfile::IsEnabled())
+      PhononAllocProfile::Instance()->Report(G4cout);
+    if (PhononRunLength::Instance()->IsActive())
+      PhononRunLength::Instance()->Report(G4cout);
+  }
+}
+
+
+// Sinks only reopen if the expanded name or the output format changed
+
+void PhononRunAction::OpenOutputFiles(G4int runID) {
+  steppingAction->SetOutputFile(
+    PhononConfigManager::GetOutputName(PhononConfigManager::GetTrackingOutput(),
+				       runID));
+
+  auto* sensitivity = dynamic_cast<PhononSensitivity*>(
+    G4SDManager::GetSDMpointer()->FindSensitiveDetector("PhononElectrode",
+							false));
+  if (sensitivity) {
+    sensitivity->SetOutputFile(
+      PhononConfigManager::GetOutputName(PhononConfigManager::GetHitOutput(),
+					 runID));
+  }
+
+  tracer.Configure(runID,
+    PhononConfigManager::GetOutputName(PhononConfigManager::GetTraceFile(),
+				       runID));
+
+  PhononHistoryRecorder* recorder = PhononHistoryRecorder::GetThreadRecorder();
+  if (recorder) {
+    recorder->SetOutputFile(
+      PhononConfigManager::GetOutputName(PhononConfigManager::GetHistoryFile(),
+					 runID));
+  }
+}
+
@@ -0,0 +1,156 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononRunLength.cc
+//
+// Description:	Singleton controller for adaptive run length, stopping
+//		a run once batch-means uncertainties reach their target.
+
+#include "PhononRunLength.hh"
+#include "PhononConfigManager.hh"
+#include "G4SystemOfUnits.hh"
+#include <cmath>
+#include <ostream>
+
+
+namespace {
+  // Fewer batches give unreliable variance estimates
+  const size_t minBatches = 10;
+
+  const char* estimatorNames[] = { "kid", "eta", "tau" };
+}
+
+
+// Constructor and Singleton Initializer
+
+PhononRunLength* PhononRunLength::theInstance = 0;
+
+PhononRunLength* PhononRunLength::Instance() {
+  static std::once_flag created;
+  std::call_once(created, [] { theInstance = new PhononRunLength; });
+  return theInstance;
+}
+
+PhononRunLength::PhononRunLength()
+  : target(0.), stop(false), eventsAtStop(0), lateEvents(0),
+    partialEvents(0) {;}
+
+const char* PhononRunLength::GetName(G4int estimator) {
+  return (estimator >= 0 && estimator < kNEstimators)
+    ? estimatorNames[estimator] : "unknown";
+}
+
+
+void PhononRunLength::BeginRun() {
+  std::lock_guard<std::mutex> lock(batchMutex);
+
+  target = PhononConfigManager::GetTargetPrecision();
+  batches.clear();
+  selected.clear();
+  stop = false;
+  eventsAtStop = 0;
+  lateEvents = partialEvents = 0;
+
+  for (const G4String& name : PhononConfigManager::GetPrecisionEstimators()) {
+    G4int i = 0;
+    while (i < kNEstimators && name != estimatorNames[i]) i++;
+
+    if (i < kNEstimators) selected.push_back(i);
+    else {
+      G4ExceptionDescription msg;
+      msg << "Unknown estimator " << name << "; expected kid, eta or tau.";
+      G4Exception("PhononRunLength::BeginRun", "PhonRunLen001",
+		  JustWarning, msg);
+    }
+  }
+
+  if (selected.empty()) target = 0.;
+}
+
+
+void PhononRunLength::AddBatch(const Sums& batch) {
+  std::lock_guard<std::mutex> lock(batchMutex);
+  if (stop) {			// Late batches from other workers
+    lateEvents += batch.events;
+    return;
+  }
+
+  batches.push_back(batch);
+  if (batches.size() < minBatches) return;
+
+  for (G4int i : selected) {
+    G4double value, error;
+    Estimate(batches, i, value, error);
+    if (value == 0. || error > target*std::fabs(value)) return;
+  }
+
+  for (const Sums& sums : batches) eventsAtStop += sums.events;
+  stop = true;
+}
+
+
+void PhononRunLength::DiscardPartial(G4long events) {
+  std::lock_guard<std::mutex> lock(batchMutex);
+  partialEvents += events;
+}
+
+
+// Ratio R = sum(num)/sum(den); with z_b = num_b - R*den_b over n batches,
+// var(R) = sum(z_b^2) / (n(n-1) mean(den)^2)
+
+void PhononRunLength::Estimate(const std::vector<Sums>& batches, G4int i,
+			       G4double& value, G4double& error) {
+  value = error = 0.;
+  size_t n = batches.size();
+  if (n == 0) return;
+
+  G4double sumNum = 0., sumDen = 0.;
+  for (const Sums& sums : batches) {
+    sumNum += sums.num[i];
+    sumDen += sums.den[i];
+  }
+  if (sumDen <= 0.) return;
+
+  value = sumNum/sumDen;
+  if (n < 2) return;
+
+  G4double sumZ2 = 0.;
+  for (const Sums& sums : batches) {
+    G4double z = sums.num[i] - value*sums.den[i];
+    sumZ2 += z*z;
+  }
+
+  G4double meanDen = sumDen/n;
+  error = std::sqrt(sumZ2/(n*(n-1.))) / meanDen;
+}
+
+
+void PhononRunLength::Report(std::ostream& os) const {
+  std::lock_guard<std::mutex> lock(batchMutex);
+
+  G4long events = 0;
+  for (const Sums& sums : batches) events += sums.events;
+
+  os << "Adaptive run length: target " << 100.*target << "%, "
+     << batches.size() << " batches (" << events << " events), ";
+  if (stop) os << "target reached after " << eventsAtStop << " events\n";
+  else os << "target NOT reached before event cap\n";
+
+  os << "  discarded " << lateEvents << " events in batches after the stop and "
+     << partialEvents << " in partial batches; the stopping point depends on"
+     << " batch arrival order, so results are not reproducible\n";
+
+  for (G4int i=0; i<kNEstimators; i++) {
+    G4double value, error;
+    Estimate(batches, i, value, error);
+
+    G4double unit = (i == kTau) ? us : 1.;
+    os << "  " << estimatorNames[i] << " = " << value/unit << " +- "
+       << error/unit << (i == kTau ? " us" : "") << " ("
+       << (value != 0. ? 100.*error/std::fabs(value) : 0.) << "%)\n";
+  }
+  os << std::flush;
+}
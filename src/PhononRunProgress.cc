@@ -0,0 +1,168 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononRunProgress.cc
+//
+// Description:	Singleton registry of live run counters for the phonon
+//		example, with a master-side heartbeat thread.
+
+#include "PhononRunProgress.hh"
+#include "G4SystemOfUnits.hh"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+
+// Constructor and Singleton Initializer
+
+PhononRunProgress* PhononRunProgress::theInstance = 0;
+
+PhononRunProgress* PhononRunProgress::Instance() {
+  static std::once_flag created;
+  std::call_once(created, [] { theInstance = new PhononRunProgress; });
+  return theInstance;
+}
+
+PhononRunProgress::PhononRunProgress()
+  : runStart(std::chrono::steady_clock::now()), runID(-1),
+    eventsToProcess(0), running(false), stopHeartbeat(false),
+    heartbeatInterval(0.), statusFile("") {;}
+
+PhononRunProgress::~PhononRunProgress() {
+  EndRun();
+}
+
+
+// Each worker asks once, at construction of its user actions
+
+PhononRunProgress::Counters* PhononRunProgress::GetCounters(G4int threadID) {
+  std::lock_guard<std::mutex> lock(countersMutex);
+  std::unique_ptr<Counters>& slot = counters[threadID];
+  if (!slot) slot.reset(new Counters);
+  return slot.get();
+}
+
+
+// Reset counters for new run and launch heartbeat if requested
+
+void PhononRunProgress::BeginRun(G4int id, G4int nEvents, G4double interval,
+				 const G4String& fileName) {
+  EndRun();		// Make sure previous heartbeat is gone
+
+  {
+    std::lock_guard<std::mutex> lock(countersMutex);
+    for (auto& slot : counters) {
+      slot.second->events.store(0, std::memory_order_relaxed);
+      slot.second->liveTracks.store(0, std::memory_order_relaxed);
+    }
+    runStart = std::chrono::steady_clock::now();
+  }
+
+  runID = id;
+  eventsToProcess = nEvents;
+  running = true;
+
+  statusFile = (interval > 0.) ? fileName : G4String("");
+  if (interval <= 0.) return;
+
+  heartbeatInterval = interval;
+  stopHeartbeat = false;
+  heartbeat = std::thread(&PhononRunProgress::Heartbeat, this);
+}
+
+void PhononRunProgress::EndRun() {
+  if (heartbeat.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(heartbeatMutex);
+      stopHeartbeat = true;
+    }
+    heartbeatWake.notify_all();
+    heartbeat.join();
+  }
+
+  // Leave final counters in the status file for whoever polls it
+  if (running.exchange(false) && !statusFile.empty()) WriteStatusFile();
+}
+
+
+// Background thread: sleep for interval, report, repeat until stopped.
+// G4cout is thread-local in MT builds and unsafe here; use std::cout.
+
+void PhononRunProgress::Heartbeat() {
+  const auto period = std::chrono::duration<G4double>(heartbeatInterval/s);
+
+  std::unique_lock<std::mutex> lock(heartbeatMutex);
+  while (!heartbeatWake.wait_for(lock, period, [this]{return stopHeartbeat;})) {
+    std::ostringstream line;
+    Report(line);
+    std::cout << line.str() << std::endl;
+    if (!statusFile.empty()) WriteStatusFile();
+  }
+}
+
+// Write to a temporary and rename, so readers never see a partial file
+
+void PhononRunProgress::WriteStatusFile() const {
+  G4String tmpName = statusFile + ".tmp";
+  std::ofstream status(tmpName, std::ios_base::trunc);
+  if (!status.good()) return;
+
+  Report(status);
+  status << std::endl;
+  status.close();
+  std::rename(tmpName.c_str(), statusFile.c_str());
+}
+
+
+// Snapshot of counters; values may be slightly stale, never inconsistent
+
+void PhononRunProgress::Report(std::ostream& os) const {
+  G4int done = 0, live = 0;
+  std::ostringstream perWorker;
+  std::chrono::steady_clock::time_point start;
+  {
+    std::lock_guard<std::mutex> lock(countersMutex);
+    start = runStart;
+    for (const auto& slot : counters) {
+      G4int nEvt = slot.second->events.load(std::memory_order_relaxed);
+      done += nEvt;
+      live += slot.second->liveTracks.load(std::memory_order_relaxed);
+      perWorker << ' ' << slot.first << ':' << nEvt;
+    }
+  }
+
+  G4double elapsed = std::chrono::duration<G4double>(
+    std::chrono::steady_clock::now() - start).count();
+  G4double rate = (elapsed > 0.) ? done/elapsed : 0.;
+  G4int total = eventsToProcess.load();
+
+  os << "Run " << runID.load() << (running ? "" : " (idle)") << ": "
+     << done << '/' << total << " events";
+  if (total > 0) {
+    os << " (" << std::fixed << std::setprecision(1)
+       << 100.*done/total << "%)";
+  }
+  os << std::fixed << std::setprecision(1) << ", " << rate << " evt/s, "
+     << live << " live tracks, RSS " << GetResidentMemory()/(1024.*1024.)
+     << " MB, ETA ";
+  if (rate > 0. && total >= done) os << (total-done)/rate << " s";
+  else os << "unknown";
+  os << std::defaultfloat << " | events per worker:" << perWorker.str();
+}
+
+
+// Current resident set size from /proc (Linux); zero elsewhere
+
+G4double PhononRunProgress::GetResidentMemory() {
+  std::ifstream statm("/proc/self/statm");
+  long pages = 0, resident = 0;
+  if (!(statm >> pages >> resident)) return 0.;
+
+  return G4double(resident) * sysconf(_SC_PAGESIZE);
+}
@@ -0,0 +1,154 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononScanTally.cc
+//
+// Description:	Per-injection-point response tally for position scans.
+
+#include "PhononScanTally.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononConfigManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ThreeVector.hh"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <ostream>
+
+
+PhononScanTally::PhononScanTally(const G4String& name)
+  : PhononAccumulableT<PhononScanTally>(name) {;}
+
+
+void PhononScanTally::Configure() {
+  points.assign(PhononConfigManager::GetScanPoints(), Point());
+  event = Point();
+}
+
+
+void PhononScanTally::Score(const G4String& volume, G4double energy,
+			    G4double time) {
+  if (volume == "KID") {
+    event.absorbed[kKID] += energy;
+    event.kidTime += energy*time;
+    event.kidTimeSq += energy*time*time;
+  }
+  else if (volume == "Feedline") event.absorbed[kFeedline] += energy;
+  else if (volume.find("TeflonSupport") == 0) event.absorbed[kTeflon] += energy;
+}
+
+void PhononScanTally::BeginEvent() {
+  event = Point();
+}
+
+// Same mapping from event to point as PhononPrimaryGeneratorAction
+
+void PhononScanTally::EndEvent(G4int eventID, G4double injectedEnergy) {
+  Point& point = points[eventID % points.size()];
+
+  point.events++;
+  point.injected += injectedEnergy;
+  for (G4int i=0; i<kNSensors; i++) point.absorbed[i] += event.absorbed[i];
+  point.kidTime += event.kidTime;
+  point.kidTimeSq += event.kidTimeSq;
+
+  G4double kid = event.absorbed[kKID];
+  point.kidSq += kid*kid;
+  point.injectedSq += injectedEnergy*injectedEnergy;
+  point.kidInjected += kid*injectedEnergy;
+
+  event = Point();
+}
+
+
+// Every thread has the same grid, as Configure() runs everywhere
+
+void PhononScanTally::Add(const PhononScanTally& tally) {
+  if (tally.points.size() != points.size()) return;	// Not configured
+
+  for (size_t p=0; p<points.size(); p++) {
+    Point& point = points[p];
+    const Point& add = tally.points[p];
+    point.events += add.events;
+    point.injected += add.injected;
+    for (G4int i=0; i<kNSensors; i++) point.absorbed[i] += add.absorbed[i];
+    point.kidSq += add.kidSq;
+    point.injectedSq += add.injectedSq;
+    point.kidInjected += add.kidInjected;
+    point.kidTime += add.kidTime;
+    point.kidTimeSq += add.kidTimeSq;
+  }
+}
+
+void PhononScanTally::Reset() {
+  for (Point& point : points) point = Point();
+  event = Point();
+}
+
+
+void PhononScanTally::EndOfRun(G4int runID, std::ostream& os) const {
+  PhononAllocProfile::Scope phase(PhononAllocProfile::kOutput);
+
+  G4String fileName =
+    PhononConfigManager::GetOutputName(PhononConfigManager::GetScanFile(),
+				       runID);
+
+  if (!Write(fileName)) {
+    G4ExceptionDescription msg;
+    msg << "Error writing scan tally to " << fileName;
+    G4Exception("PhononScanTally::EndOfRun", "PhonRun002",
+		JustWarning, msg);
+    return;
+  }
+
+  os << "Scan tally: " << points.size() << " injection points written to "
+     << fileName << std::endl;
+}
+
+
+// Efficiencies are absorbed/injected energy.  The KID error is the delta
+// method standard error of that ratio, sqrt(n/(n-1) * sum(z^2)) / sum(d)
+// with z = a - R*d, expanding sum(z^2) in the stored sums.
+
+G4bool PhononScanTally::Write(const G4String& fileName) const {
+  std::ofstream out(fileName, std::ios_base::trunc);
+  if (!out.good()) return false;
+
+  out << "point,x_mm,y_mm,events,injected_eV,eff_KID,eff_KID_err,"
+      << "eff_Feedline,eff_Teflon,t_KID_mean_us,t_KID_rms_us\n";
+
+  for (size_t p=0; p<points.size(); p++) {
+    const Point& point = points[p];
+    G4ThreeVector pos = PhononConfigManager::GetScanPosition(p);
+
+    G4double norm = (point.injected > 0.) ? 1./point.injected : 0.;
+    G4double kidEff = point.absorbed[kKID]*norm;
+
+    G4double kidErr = 0.;
+    if (point.events > 1 && point.injected > 0.) {
+      G4double zSq = point.kidSq - 2.*kidEff*point.kidInjected
+	+ kidEff*kidEff*point.injectedSq;
+      G4double n = point.events;
+      kidErr = std::sqrt(std::max(zSq, 0.)*n/(n-1.)) * norm;
+    }
+
+    G4double tMean = 0., tRms = 0.;
+    if (point.absorbed[kKID] > 0.) {
+      tMean = point.kidTime / point.absorbed[kKID];
+      tRms = std::sqrt(std::max(point.kidTimeSq/point.absorbed[kKID]
+				- tMean*tMean, 0.));
+    }
+
+    out << p << ',' << pos.x()/mm << ',' << pos.y()/mm << ','
+	<< point.events << ',' << point.injected/eV << ','
+	<< kidEff << ',' << kidErr << ','
+	<< point.absorbed[kFeedline]*norm << ','
+	<< point.absorbed[kTeflon]*norm << ','
+	<< tMean/us << ',' << tRms/us << '\n';
+  }
+
+  return out.good();
+}
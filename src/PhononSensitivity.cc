@@ -14,14 +14,16 @@
 #include "G4RunManager.hh"
 #include "G4SDManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "PhononAllocProfile.hh"
 #include "PhononConfigManager.hh"
 #include <fstream>
 
 
+// Output file is opened by PhononRunAction at start of each run
+
 PhononSensitivity::PhononSensitivity(G4String name) :
-  G4CMPElectrodeSensitivity(name), fileName("") {
-  SetOutputFile(PhononConfigManager::GetHitOutput());
-}
+  G4CMPElectrodeSensitivity(name), fileName(""), outputFormat(""),
+  delimiter(',') {;}
 
 /* Move is disabled for now because old versions of GCC can't move ofstream
 PhononSensitivity::PhononSensitivity(PhononSensitivity&& in) :
@@ -52,50 +54,68 @@ PhononSensitivity::~PhononSensitivity() {
 }
 
 void PhononSensitivity::EndOfEvent(G4HCofThisEvent* HCE) {
+  PhononAllocProfile::SetPhase(PhononAllocProfile::kEndOfEvent);
+
   G4int HCID = G4SDManager::GetSDMpointer()->GetCollectionID(hitsCollection);
   auto* hitCol = static_cast<G4CMPElectrodeHitsCollection*>(HCE->GetHC(HCID));
-  std::vector<G4CMPElectrodeHit*>* hitVec = hitCol->GetVector();
-
-  G4RunManager* runMan = G4RunManager::GetRunManager();
-
-  if (output.good()) {
-    for (G4CMPElectrodeHit* hit : *hitVec) {
-      output << runMan->GetCurrentRun()->GetRunID() << ','
-             << runMan->GetCurrentEvent()->GetEventID() << ','
-             << hit->GetTrackID() << ','
-             << hit->GetParticleName() << ','
-             << hit->GetStartEnergy()/eV << ','
-             << hit->GetStartPosition().getX()/m << ','
-             << hit->GetStartPosition().getY()/m << ','
-             << hit->GetStartPosition().getZ()/m << ','
-             << hit->GetStartTime()/ns << ','
-             << hit->GetEnergyDeposit()/eV << ','
-             << hit->GetWeight() << ','
-             << hit->GetFinalPosition().getX()/m << ','
-             << hit->GetFinalPosition().getY()/m << ','
-             << hit->GetFinalPosition().getZ()/m << ','
+  const std::vector<G4CMPElectrodeHit*>& hitVec = *hitCol->GetVector();
+
+  if (output.is_open() && output.good()) {
+    PhononAllocProfile::Scope phase(PhononAllocProfile::kOutput);
+
+    G4RunManager* runMan = G4RunManager::GetRunManager();
+    const G4int runID = runMan->GetCurrentRun()->GetRunID();
+    const G4int eventID = runMan->GetCurrentEvent()->GetEventID();
+
+    const char d = delimiter;
+    for (const G4CMPElectrodeHit* hit : hitVec) {
+      output << runID << d
+             << eventID << d
+             << hit->GetTrackID() << d
+             << hit->GetParticleName() << d
+             << hit->GetStartEnergy()/eV << d
+             << hit->GetStartPosition().getX()/m << d
+             << hit->GetStartPosition().getY()/m << d
+             << hit->GetStartPosition().getZ()/m << d
+             << hit->GetStartTime()/ns << d
+             << hit->GetEnergyDeposit()/eV << d
+             << hit->GetWeight() << d
+             << hit->GetFinalPosition().getX()/m << d
+             << hit->GetFinalPosition().getY()/m << d
+             << hit->GetFinalPosition().getZ()/m << d
              << hit->GetFinalTime()/ns << '\n';
     }
   }
 }
 
 void PhononSensitivity::SetOutputFile(const G4String &fn) {
-  if (fileName != fn) {
-    if (output.is_open()) output.close();
-    fileName = fn;
-    output.open(fileName, std::ios_base::app);
-    if (!output.good()) {
-      G4ExceptionDescription msg;
-      msg << "Error opening output file " << fileName;
-      G4Exception("PhononSensitivity::SetOutputFile", "PhonSense003",
-                  FatalException, msg);
-      output.close();
-    } else {
-      output << "Run ID,Event ID,Track ID,Particle Name,Start Energy [eV],"
-             << "Start X [m],Start Y [m],Start Z [m],Start Time [ns],"
-             << "Energy Deposited [eV],Track Weight,End X [m],End Y [m],End Z [m],"
-             << "Final Time [ns]\n";
-    }
+  const G4String& format = PhononConfigManager::GetOutputFormat();
+  if (fileName == fn && outputFormat == format) return;
+
+  if (output.is_open()) output.close();
+  fileName = fn;
+  outputFormat = format;
+  if (outputFormat == "none") return;
+
+  delimiter = (outputFormat == "tsv") ? '\t' : ',';
+  output.open(fileName, std::ios_base::app);
+  if (!output.good()) {
+    G4ExceptionDescription msg;
+    msg << "Error opening output file " << fileName;
+    G4Exception("PhononSensitivity::SetOutputFile", "PhonSense003",
+                FatalException, msg);
+    output.close();
+  } else {
+    const char* columns[] = {
+      "Run ID", "Event ID", "Track ID", "Particle Name", "Start Energy [eV]",
+      "Start X [m]", "Start Y [m]", "Start Z [m]", "Start Time [ns]",
+      "Energy Deposited [eV]", "Track Weight", "End X [m]", "End Y [m]",
+      "End Z [m]", "Final Time [ns]"
+    };
+    output << columns[0];
+    for (size_t i=1; i<sizeof(columns)/sizeof(columns[0]); i++)
+      output << delimiter << columns[i];
+    output << '\n';
   }
 }
 
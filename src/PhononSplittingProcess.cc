@@ -0,0 +1,49 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononSplittingProcess.cc
+//
+// Description:	Forced process applying importance splitting to phonons.
+
+#include "PhononSplittingProcess.hh"
+#include "PhononImportanceSplitter.hh"
+#include "G4PhononPolarization.hh"
+#include "G4Track.hh"
+
+
+PhononSplittingProcess::PhononSplittingProcess(const G4String& name)
+  : G4VDiscreteProcess(name, fGeneral) {
+  pParticleChange = &change;
+}
+
+G4bool
+PhononSplittingProcess::IsApplicable(const G4ParticleDefinition& particle) {
+  return G4PhononPolarization::Get(&particle) != G4PhononPolarization::UNKNOWN;
+}
+
+
+// Never limits the step; forced after every step while splitting is on
+
+G4double PhononSplittingProcess::
+PostStepGetPhysicalInteractionLength(const G4Track&, G4double,
+				     G4ForceCondition* condition) {
+  PhononImportanceSplitter* splitter =
+    PhononImportanceSplitter::GetThreadSplitter();
+  *condition = (splitter && splitter->IsActive()) ? StronglyForced : NotForced;
+  return DBL_MAX;
+}
+
+G4VParticleChange*
+PhononSplittingProcess::PostStepDoIt(const G4Track& track,
+				     const G4Step& step) {
+  change.Initialize(track);
+
+  PhononImportanceSplitter* splitter =
+    PhononImportanceSplitter::GetThreadSplitter();
+  if (splitter && splitter->IsActive()) splitter->Apply(step, change);
+
+  return &change;
+}
@@ -0,0 +1,74 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononStackingAction.cc
+//
+// Description:	Stacking action for G4CMP phonon example, with optional
+//		merging of downconversion secondaries.
+
+#include "PhononStackingAction.hh"
+#include "PhononMacroMerger.hh"
+#include "G4EventManager.hh"
+#include "G4StackManager.hh"
+#include "G4Track.hh"
+#include "G4TrackVector.hh"
+
+
+PhononStackingAction::PhononStackingAction()
+  : G4CMPStackingAction(), macroMerger(0), mode(kStacking) {;}
+
+
+// Tracks seen during our own reclassification are already initialized
+
+G4ClassificationOfNewTrack
+PhononStackingAction::ClassifyNewTrack(const G4Track* track) {
+  if (mode == kCollecting) {
+    stage.push_back(track);
+    return fUrgent;
+  }
+
+  if (mode == kDiscarding) return (discard.count(track) ? fKill : fUrgent);
+
+  G4ClassificationOfNewTrack classification =
+    G4CMPStackingAction::ClassifyNewTrack(track);
+
+  if (classification == fUrgent && macroMerger && macroMerger->IsActive() &&
+      size_t(stackManager->GetNTotalTrack()) > macroMerger->GetMaxTracks() &&
+      macroMerger->IsCandidate(track)) classification = fWaiting;
+
+  return classification;
+}
+
+
+// Waiting stack has just been moved to the (empty) urgent stack.  New
+// macro-phonons are stacked while still discarding, which makes them
+// urgent; they already have track info from G4CMP::CreatePhonon.
+
+void PhononStackingAction::NewStage() {
+  G4CMPStackingAction::NewStage();
+  if (!macroMerger || !macroMerger->IsActive()) return;
+
+  mode = kCollecting;
+  stackManager->ReClassify();
+
+  G4TrackVector macros;
+  if (macroMerger->MergeStage(stage, discard, macros)) {
+    mode = kDiscarding;
+    stackManager->ReClassify();
+    G4EventManager::GetEventManager()->StackTracks(&macros);
+  }
+
+  mode = kStacking;
+  stage.clear();
+  discard.clear();
+}
+
+void PhononStackingAction::PrepareNewEvent() {
+  G4CMPStackingAction::PrepareNewEvent();
+  mode = kStacking;
+  stage.clear();
+  discard.clear();
+}
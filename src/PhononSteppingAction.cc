@@ -1,4 +1,10 @@
 #include "PhononSteppingAction.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononBatchMonitor.hh"
+#include "PhononConfigManager.hh"
+#include "PhononEnergyTally.hh"
+#include "PhononScanTally.hh"
+#include "PhononTrajectoryTracer.hh"
 #include "G4Step.hh"
 #include "G4StepPoint.hh"
 #include "G4Track.hh"
@@ -7,17 +13,42 @@
 #include "G4PhononTransFast.hh"
 #include "G4PhononLong.hh"
 
-// Constructor: open file and write header line
-PhononSteppingAction::PhononSteppingAction() {
-    fout_.open("phonon_tracking.csv");
-    fout_ << "trackID, stepNumber, x/nm, y/nm, z/nm, time_ns, energy_meV, volume\n";
-}
+// Constructor: file is opened by the run action once the run ID is known
+PhononSteppingAction::PhononSteppingAction() : delim_(','), energyTally_(0),
+    scanTally_(0), batchMonitor_(0), tracer_(0) {}
 
 // Destructor: close file
 PhononSteppingAction::~PhononSteppingAction() {
     if (fout_.is_open()) fout_.close();
 }
 
+// Open file (truncating) and write header line
+void PhononSteppingAction::SetOutputFile(const G4String& fileName) {
+    const G4String& format = PhononConfigManager::GetOutputFormat();
+    if (fileName == fileName_ && format == format_) return;
+
+    if (fout_.is_open()) fout_.close();
+    fileName_ = fileName;
+    format_ = format;
+    if (format_ == "none") return;
+
+    delim_ = (format_ == "tsv") ? '\t' : ',';
+    fout_.open(fileName_);
+    if (!fout_.good()) {
+        G4ExceptionDescription msg;
+        msg << "Error opening output file " << fileName_;
+        G4Exception("PhononSteppingAction::SetOutputFile", "PhonStep001",
+                    FatalException, msg);
+        fout_.close();
+        return;
+    }
+
+    const char d = delim_;
+    fout_ << "trackID" << d << " stepNumber" << d << " x/nm" << d << " y/nm"
+          << d << " z/nm" << d << " time_ns" << d << " energy_meV" << d
+          << " volume" << d << " weight\n";
+}
+
 void PhononSteppingAction::UserSteppingAction(const G4Step* step) {
     auto track = step->GetTrack();
     if (track->GetDefinition() != G4PhononLong::Definition() && 
@@ -25,19 +56,27 @@ void PhononSteppingAction::UserSteppingAction(const G4Step* step) {
         track->GetDefinition() != G4PhononTransFast::Definition())
         return;
 
+    if (energyTally_ && energyTally_->IsActive()) energyTally_->Score(step);
+    if (tracer_) tracer_->Record(step);
     
     auto prePoint = step->GetPreStepPoint();
     auto postPoint = step->GetPostStepPoint();
 
+    const char d = delim_;
+    const G4bool writing = fout_.is_open();
+
     // stop tracking the phonon if it's below 2*Delta ~ 400 ueV
     if (prePoint->GetKineticEnergy() < 400 * eV * 1e-6) {
         auto pos = postPoint->GetPosition();
         auto time = postPoint->GetGlobalTime();
         auto energy = prePoint->GetKineticEnergy();
-        fout_ << track->GetTrackID() << "," << track->GetCurrentStepNumber() << ","
-            << pos.x() / nm << "," << pos.y() / nm << "," << pos.z() / nm << ","
-            << time / ns << "," << energy / eV * 1e3 << ","
-            << "BelowGap" << "\n";
+        if (writing) {
+            PhononAllocProfile::Scope phase(PhononAllocProfile::kOutput);
+            fout_ << track->GetTrackID() << d << track->GetCurrentStepNumber() << d
+                << pos.x() / nm << d << pos.y() / nm << d << pos.z() / nm << d
+                << time / ns << d << energy / eV * 1e3 << d
+                << "BelowGap" << d << track->GetWeight() << "\n";
+        }
         track->SetTrackStatus(fStopAndKill);
     }
 
@@ -63,11 +102,24 @@ void PhononSteppingAction::UserSteppingAction(const G4Step* step) {
     auto time = postPoint->GetGlobalTime();    
     auto energy = prePoint->GetKineticEnergy();  
 
+    G4double absorbed = step->GetNonIonizingEnergyDeposit() * track->GetWeight();
+    if (scanTally_ && scanTally_->IsActive()) {
+        scanTally_->Score(postPoint->GetPhysicalVolume()->GetName(), absorbed, time);
+    }
+    if (batchMonitor_ && batchMonitor_->IsActive()) {
+        batchMonitor_->Score(postPoint->GetPhysicalVolume()->GetName(), absorbed, time);
+    }
+
+    if (!writing) return;
+
+    PhononAllocProfile::Scope phase(PhononAllocProfile::kOutput);
+
     // note that for such geometric crossings, our post-step point will always be on the boundary
     // thus the z value will not be interesting. However, the step will now be in the new volume
-    fout_ << track->GetTrackID() << "," << track->GetCurrentStepNumber() << ","
-        << pos.x() / nm << "," << pos.y() / nm << "," << pos.z() / nm << ","
-        << time / ns << "," << energy / eV * 1e3 << "," 
-        << postPoint->GetPhysicalVolume()->GetName() << "\n";
+    fout_ << track->GetTrackID() << d << track->GetCurrentStepNumber() << d
+        << pos.x() / nm << d << pos.y() / nm << d << pos.z() / nm << d
+        << time / ns << d << energy / eV * 1e3 << d
+        << postPoint->GetPhysicalVolume()->GetName() << d
+        << track->GetWeight() << "\n";
     
 }
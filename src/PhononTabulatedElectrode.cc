@@ -0,0 +1,210 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononTabulatedElectrode.cc
+//
+// Description:	Phonon sensor sampling from precomputed KaplanQP tables.
+
+#include "PhononTabulatedElectrode.hh"
+#include "PhononConfigManager.hh"
+#include "G4CMPKaplanQP.hh"
+#include "G4CMPSecondaryUtils.hh"
+#include "G4CMPUtils.hh"
+#include "G4LatticeManager.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4ParticleChange.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "Randomize.hh"
+#include "CLHEP/Random/MixMaxRng.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <sstream>
+
+
+namespace {
+  const G4int nTableEnergies = 64;
+  const G4double tableMaxEnergy = 0.1*eV;	// Above Si phonon spectrum
+
+  // Film properties read by KaplanQP; together they identify a table
+  const char* filmKeys[] = { "filmThickness", "gapEnergy", "lowQPLimit",
+			     "highQPLimit", "phononLifetime",
+			     "phononLifetimeSlope", "vSound",
+			     "subgapAbsorption", "temperature" };
+
+  G4String TableKey(const G4MaterialPropertiesTable* film, G4int nSamples) {
+    std::ostringstream key;
+    key.precision(17);
+    for (const char* name : filmKeys) {
+      if (film->ConstPropertyExists(name))
+	key << name << '=' << film->GetConstProperty(name) << ';';
+    }
+    key << "samples=" << nSamples;
+    return key.str();
+  }
+
+  // KaplanQP draws from G4Random and takes no engine of its own, so the
+  // table engine is installed only while this is in scope; the caller's
+  // engine is restored on every exit, including exceptions
+  class ScopedEngine {
+  public:
+    explicit ScopedEngine(CLHEP::HepRandomEngine& engine)
+      : saved(G4Random::getTheEngine()) { G4Random::setTheEngine(&engine); }
+    ~ScopedEngine() { G4Random::setTheEngine(saved); }
+
+    ScopedEngine(const ScopedEngine&) = delete;
+    ScopedEngine& operator=(const ScopedEngine&) = delete;
+
+  private:
+    CLHEP::HepRandomEngine* saved;
+  };
+
+  // KaplanQP only reads the table, but does not declare it const
+  G4double RunKaplanQP(G4double energy, const G4MaterialPropertiesTable* film,
+		       std::vector<G4double>& reflected) {
+    reflected.clear();
+    return G4CMP::KaplanPhononQP(energy,
+			 const_cast<G4MaterialPropertiesTable*>(film),
+				 reflected);
+  }
+}
+
+
+// Tables are shared by all threads and clones
+
+std::map<G4String, std::shared_ptr<const PhononTabulatedElectrode::Table> >
+PhononTabulatedElectrode::tableCache;
+
+std::mutex PhononTabulatedElectrode::tableMutex;
+
+
+PhononTabulatedElectrode::
+PhononTabulatedElectrode(const G4MaterialPropertiesTable* film)
+  : table(GetTable(film)) {;}
+
+
+// Replaces G4CMPPhononElectrode's KaplanQP call; secondaries are created
+// the same way, reflected back into the substrate
+
+void PhononTabulatedElectrode::
+AbsorbAtElectrode(const G4Track& track, const G4Step& step,
+		  G4ParticleChange& particleChange) const {
+  std::vector<G4double> reflected;
+  G4double eDep = Sample(track.GetKineticEnergy(), reflected);
+
+  particleChange.ProposeNonIonizingEnergyDeposit(eDep);
+  particleChange.ProposeTrackStatus(fStopAndKill);
+  if (reflected.empty()) return;
+
+  const G4StepPoint* prePoint = step.GetPreStepPoint();
+  const G4LatticePhysical* lattice =
+    G4LatticeManager::GetLatticeManager()->GetLattice(prePoint->GetPhysicalVolume());
+  G4ThreeVector surfNorm = G4CMP::GetSurfaceNormal(step);
+
+  particleChange.SetNumberOfSecondaries(reflected.size());
+  for (G4double energy : reflected) {
+    G4int mode = G4CMP::ChoosePhononPolarization(lattice);
+    G4Track* phonon =
+      G4CMP::CreatePhonon(prePoint->GetTouchable(), mode,
+			  G4CMP::LambertReflection(surfNorm), energy,
+			  track.GetGlobalTime(), track.GetPosition());
+    particleChange.AddSecondary(phonon);
+  }
+}
+
+
+// Pick one stored outcome, choosing between the two bracketing grid
+// energies with linear weight in ln(E).  The table's minimum energy is
+// the threshold, so a fraction f is above it at grid energy E_i when
+// f > minEnergy/E_i, and after scaling when f > minEnergy/E.
+
+G4double PhononTabulatedElectrode::
+Sample(G4double energy, std::vector<G4double>& reflected) const {
+  if (energy < table->minEnergy || energy > table->maxEnergy)
+    return RunKaplanQP(energy, theSurfaceTable, reflected);
+
+  G4double u = std::log(energy/table->minEnergy) / table->logStep;
+  G4int bin = G4int(u);
+  if (G4UniformRand() < u-bin) bin++;
+  bin = std::min(bin, table->nEnergies-1);
+
+  size_t outcome = size_t(bin)*table->nSamples
+    + std::min(G4int(G4UniformRand()*table->nSamples), table->nSamples-1);
+
+  G4double nodeThreshold = std::exp(-bin*table->logStep);
+  G4double threshold = table->minEnergy/energy;
+
+  reflected.clear();
+  G4double eReflected = 0.;
+  for (size_t i=table->first[outcome]; i<table->first[outcome+1]; i++) {
+    G4double f = table->fractions[i];
+    if ((f >= nodeThreshold) != (f >= threshold))
+      return RunKaplanQP(energy, theSurfaceTable, reflected);
+
+    reflected.push_back(f*energy);
+    eReflected += reflected.back();
+  }
+
+  return std::max(energy-eReflected, 0.);
+}
+
+
+// Look up table for these film properties, building it if needed
+
+std::shared_ptr<const PhononTabulatedElectrode::Table>
+PhononTabulatedElectrode::GetTable(const G4MaterialPropertiesTable* film) {
+  G4String key = TableKey(film, PhononConfigManager::GetFilmTableSamples());
+
+  std::lock_guard<std::mutex> lock(tableMutex);
+  auto& cached = tableCache[key];
+  if (!cached) cached = BuildTable(film);
+
+  return cached;
+}
+
+std::shared_ptr<const PhononTabulatedElectrode::Table>
+PhononTabulatedElectrode::BuildTable(const G4MaterialPropertiesTable* film) {
+  auto start = std::chrono::steady_clock::now();
+
+  auto newTable = std::make_shared<Table>();
+  newTable->minEnergy = 2.*film->GetConstProperty("gapEnergy");
+  newTable->maxEnergy = tableMaxEnergy;
+  newTable->nEnergies = nTableEnergies;
+  newTable->nSamples = PhononConfigManager::GetFilmTableSamples();
+  newTable->logStep = std::log(newTable->maxEnergy/newTable->minEnergy)
+    / (nTableEnergies-1);
+
+  // Local engine, seeded from the film properties, so the table does not
+  // depend on or advance the calling thread's random sequence
+  const long seed = std::hash<std::string>()(TableKey(film, newTable->nSamples))
+    & 0x7fffffff;
+  CLHEP::MixMaxRng engine(seed);
+
+  std::vector<G4double> reflected;
+  {
+    ScopedEngine useTableEngine(engine);
+    for (G4int i=0; i<nTableEnergies; i++) {
+      G4double energy = newTable->minEnergy * std::exp(i*newTable->logStep);
+      for (G4int j=0; j<newTable->nSamples; j++) {
+	newTable->first.push_back(newTable->fractions.size());
+	RunKaplanQP(energy, film, reflected);
+	for (G4double e : reflected) newTable->fractions.push_back(e/energy);
+      }
+    }
+  }
+  newTable->first.push_back(newTable->fractions.size());
+
+  G4cout << "PhononTabulatedElectrode: " << nTableEnergies << " energies x "
+	 << newTable->nSamples << " KaplanQP samples tabulated in "
+	 << std::chrono::duration<G4double>(std::chrono::steady_clock::now()
+					    - start).count()
+	 << " s" << G4endl;
+
+  return newTable;
+}
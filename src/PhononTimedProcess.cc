@@ -0,0 +1,83 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononTimedProcess.cc
+//
+// Description:	Wrapper which times PostStep calls of a registered
+//		process.
+
+#include "PhononTimedProcess.hh"
+#include <algorithm>
+#include <time.h>
+
+
+namespace {
+  G4ThreadLocal std::vector<PhononTimedProcess*>* threadProcesses = 0;
+
+  std::vector<PhononTimedProcess*>& ThreadProcesses() {
+    if (!threadProcesses) threadProcesses = new std::vector<PhononTimedProcess*>;
+    return *threadProcesses;
+  }
+
+  // CPU time used by the calling thread, in seconds
+  inline G4double ThreadSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + 1e-9*now.tv_nsec;
+  }
+}
+
+
+// Wrapper keeps the original name and type, so lookups still find it
+
+PhononTimedProcess::PhononTimedProcess(G4VProcess* process)
+  : G4WrapperProcess(process->GetProcessName(), process->GetProcessType()),
+    lengthCalls(0), doItCalls(0), lengthTime(0.), doItTime(0.) {
+  RegisterProcess(process);
+  SetProcessSubType(process->GetProcessSubType());
+  ThreadProcesses().push_back(this);
+}
+
+PhononTimedProcess::~PhononTimedProcess() {
+  std::vector<PhononTimedProcess*>& procs = ThreadProcesses();
+  procs.erase(std::remove(procs.begin(), procs.end(), this), procs.end());
+}
+
+
+// Timed forwarding to registered process
+
+G4double PhononTimedProcess::
+PostStepGetPhysicalInteractionLength(const G4Track& track,
+				     G4double previousStepSize,
+				     G4ForceCondition* condition) {
+  G4double start = ThreadSeconds();
+  G4double length =
+    G4WrapperProcess::PostStepGetPhysicalInteractionLength(track,
+							   previousStepSize,
+							   condition);
+  lengthTime += ThreadSeconds() - start;
+  lengthCalls++;
+  return length;
+}
+
+G4VParticleChange* PhononTimedProcess::PostStepDoIt(const G4Track& track,
+						    const G4Step& step) {
+  G4double start = ThreadSeconds();
+  G4VParticleChange* change = G4WrapperProcess::PostStepDoIt(track, step);
+  doItTime += ThreadSeconds() - start;
+  doItCalls++;
+  return change;
+}
+
+void PhononTimedProcess::ResetTimers() {
+  lengthCalls = doItCalls = 0;
+  lengthTime = doItTime = 0.;
+}
+
+const std::vector<PhononTimedProcess*>&
+PhononTimedProcess::GetThreadProcesses() {
+  return ThreadProcesses();
+}
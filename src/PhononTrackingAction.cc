@@ -0,0 +1,43 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononTrackingAction.cc
+//
+// Description:	Tracking action for G4CMP phonon example.
+
+#include "PhononTrackingAction.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononHistoryRecorder.hh"
+#include "G4EventManager.hh"
+#include "G4StackManager.hh"
+#include "G4Threading.hh"
+
+
+PhononTrackingAction::PhononTrackingAction()
+  : G4UserTrackingAction(),
+    progress(PhononRunProgress::Instance()->GetCounters(G4Threading::G4GetThreadId())) {;}
+
+PhononTrackingAction::~PhononTrackingAction() {;}
+
+
+// Current track has already been popped, so count it separately
+
+void PhononTrackingAction::PreUserTrackingAction(const G4Track* track) {
+  G4int nStacked =
+    G4EventManager::GetEventManager()->GetStackManager()->GetNTotalTrack();
+  progress->liveTracks.store(nStacked+1, std::memory_order_relaxed);
+
+  if (PhononAllocProfile::IsEnabled())
+    PhononAllocProfile::NoteLiveTracks(nStacked+1);
+
+  PhononHistoryRecorder* recorder = PhononHistoryRecorder::GetThreadRecorder();
+  if (recorder) recorder->BeginTrack(track);
+}
+
+void PhononTrackingAction::PostUserTrackingAction(const G4Track* track) {
+  PhononHistoryRecorder* recorder = PhononHistoryRecorder::GetThreadRecorder();
+  if (recorder) recorder->EndTrack(track);
+}
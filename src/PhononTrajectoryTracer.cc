@@ -0,0 +1,159 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  PhononTrajectoryTracer.cc
+//
+// Description:	Per-thread sampled trajectory tracing.
+
+#include "PhononTrajectoryTracer.hh"
+#include "PhononAllocProfile.hh"
+#include "PhononConfigManager.hh"
+#include "G4Event.hh"
+#include "G4EventManager.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4VPhysicalVolume.hh"
+
+
+PhononTrajectoryTracer::PhononTrajectoryTracer()
+  : runID(0), rate(0), eventMode(false), bufferSize(1), append(false),
+    delim(','), trackID(0), selected(false), buffered(0), dropped(0) {;}
+
+
+void PhononTrajectoryTracer::Configure(G4int run, const G4String& name) {
+  runID = run;
+  rate = PhononConfigManager::GetTraceRate();
+  eventMode = (PhononConfigManager::GetTraceMode() == "event");
+  bufferSize = PhononConfigManager::GetTraceBuffer();
+  delim = (PhononConfigManager::GetOutputFormat() == "tsv") ? '\t' : ',';
+
+  trackID = 0;
+  selected = false;
+  buffer.str("");
+  buffered = 0;
+  dropped = 0;
+
+  if (name != fileName) {
+    if (fout.is_open()) fout.close();
+    append = false;
+  }
+  fileName = name;
+}
+
+void PhononTrajectoryTracer::Close() {
+  if (!fout.is_open()) return;
+
+  fout.close();			// Flushes
+  append = true;
+}
+
+
+// SplitMix64 finalizer: consecutive IDs give uncorrelated bits
+
+uint64_t PhononTrajectoryTracer::Hash(uint64_t key) {
+  key += 0x9e3779b97f4a7c15ULL;
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+  return key ^ (key >> 31);
+}
+
+void PhononTrajectoryTracer::Select(const G4Track* track) {
+  trackID = track->GetTrackID();
+  selected = false;
+
+  const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  selected = IsSelected(runID, event ? event->GetEventID() : 0, trackID,
+			rate, eventMode);
+}
+
+G4bool PhononTrajectoryTracer::IsSelected(G4int runID, G4int eventID,
+					  G4int trackID, G4int rate,
+					  G4bool eventMode) {
+  if (rate <= 0) return false;
+
+  uint64_t key = Hash((uint64_t(runID) << 32) ^ uint64_t(eventID));
+  if (!eventMode) key = Hash(key ^ uint64_t(trackID));
+  return (key % rate == 0);
+}
+
+
+void PhononTrajectoryTracer::Record(const G4Step* step) {
+  if (rate <= 0) return;
+
+  const G4Track* track = step->GetTrack();
+  G4bool first = (track->GetCurrentStepNumber() == 1);
+  if (first || track->GetTrackID() != trackID) Select(track);
+  if (!selected) return;
+
+  if (first) WriteStep(track, step, true);	// Starting point as step 0
+  WriteStep(track, step, false);
+}
+
+void PhononTrajectoryTracer::WriteStep(const G4Track* track,
+				       const G4Step* step, G4bool pre) {
+  if (buffered >= bufferSize) {
+    dropped++;
+    return;
+  }
+
+  const G4StepPoint* point = pre ? step->GetPreStepPoint()
+				 : step->GetPostStepPoint();
+
+  const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  const G4VPhysicalVolume* volume = point->GetPhysicalVolume();
+  const G4VProcess* process = point->GetProcessDefinedStep();
+  const G4ThreeVector& pos = point->GetPosition();
+  const char d = delim;
+
+  buffer << (event ? event->GetEventID() : -1) << d << track->GetTrackID()
+	 << d << track->GetParentID() << d
+	 << (pre ? 0 : track->GetCurrentStepNumber()) << d
+	 << pos.x()/nm << d << pos.y()/nm << d << pos.z()/nm << d
+	 << point->GetGlobalTime()/ns << d
+	 << point->GetKineticEnergy()/eV*1e3 << d
+	 << (volume ? volume->GetName() : G4String("OutOfWorld")) << d
+	 << (pre ? G4String("start") :
+	     process ? process->GetProcessName() : G4String("none")) << d
+	 << point->GetWeight() << '\n';
+  buffered++;
+}
+
+
+void PhononTrajectoryTracer::EndEvent() {
+  if (buffered == 0 && dropped == 0) return;
+
+  PhononAllocProfile::Scope phase(PhononAllocProfile::kOutput);
+
+  if (!fout.is_open() && !fileName.empty()) {
+    fout.open(fileName, append ? std::ios_base::app : std::ios_base::trunc);
+    if (!fout.good()) {
+      G4ExceptionDescription msg;
+      msg << "Error opening trace file " << fileName << "; tracing disabled.";
+      G4Exception("PhononTrajectoryTracer::EndEvent", "PhonTrace001",
+		  JustWarning, msg);
+      fileName = "";
+    } else if (!append) {
+      const char d = delim;
+      fout << "eventID" << d << " trackID" << d << " parentID" << d
+	   << " stepNumber" << d << " x/nm" << d << " y/nm" << d << " z/nm"
+	   << d << " time_ns" << d << " energy_meV" << d << " volume" << d
+	   << " process" << d << " weight\n";
+    }
+  }
+
+  if (fout.is_open()) {
+    fout << buffer.str();
+    if (dropped > 0)
+      fout << "# " << dropped << " steps dropped beyond TraceBuffer\n";
+  }
+
+  buffer.str("");
+  buffered = 0;
+  dropped = 0;
+}
@@ -0,0 +1,54 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  testOutputName.cc
+//
+// Description:	Check expansion of {run} and {thread} in output filename
+//		templates, the per-worker suffix when {thread} is missing,
+//		and placement in the output directory.
+//
+// Usage: testOutputName	(returns number of failures)
+
+#include "PhononConfigManager.hh"
+#include <iostream>
+
+
+namespace {
+  G4int failures = 0;
+
+  void check(const G4String& pattern, G4int run, G4int thread,
+	     const G4String& expect) {
+    G4String got = PhononConfigManager::GetOutputName(pattern, run, thread);
+    if (got == expect) return;
+    std::cerr << "FAIL " << pattern << " (run " << run << ", thread "
+	      << thread << "): got " << got << ", expected " << expect
+	      << std::endl;
+    failures++;
+  }
+}
+
+
+int main() {
+  PhononConfigManager::SetOutputDirectory("");
+  check("phonon_hits_{run}_{thread}.txt", 3, 2, "phonon_hits_3_2.txt");
+  check("{run}/{thread}_{run}.csv", 12, 7, "12/7_12.csv");
+  check("", 1, 1, "");
+
+  // Master (-1) keeps the name; workers get a thread suffix
+  check("phonon_scan.csv", 0, -1, "phonon_scan.csv");
+  check("phonon_hits.txt", 0, 0, "phonon_hits_0.txt");
+  check("run{run}/hits", 2, 3, "run2/hits_3");
+  check("v1.2/hits", 0, 1, "v1.2/hits_1");
+  check("history_{run}.bin", 5, 2, "history_5_2.bin");
+
+  PhononConfigManager::SetOutputDirectory("out");
+  check("phonon_scan.csv", 0, -1, "out/phonon_scan.csv");
+  check("run{run}/t{thread}.bin", 1, 4, "out/run1/t4.bin");
+  check("/tmp/phonon_{thread}.csv", 0, 5, "/tmp/phonon_5.csv");
+  check("", 1, 1, "");
+
+  return failures;
+}
@@ -0,0 +1,76 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  testReweightModel.cc
+//
+// Description:	Check the surface outcome model of reweight_surfaces.C:
+//		outcome probabilities are normalized and follow the
+//		G4CMPPhononBoundaryProcess sampling, and requested changes
+//		keep the reflection shares normalized.  Built only with ROOT.
+//
+// Usage: testReweightModel	(returns number of failures)
+
+#include "../reweight_surfaces.C"
+
+
+namespace {
+    int failures = 0;
+
+    void check(const char* what, double got, double expect)
+    {
+        if (std::fabs(got-expect) <= 1e-12) return;
+        std::cerr<<"FAIL "<<what<<": got "<<got<<", expected "<<expect<<std::endl;
+        failures++;
+    }
+}
+
+
+int main()
+{
+    Probs p;
+    p.abs = 0.3; p.refl = 0.8; p.anh = 0.1; p.spec = 0.25; p.diff = 0.65;
+    check("killed", OutcomeProb(p, kKilled), 0.3 + 0.7*0.2);
+    check("specular", OutcomeProb(p, kSpecular), 0.7*0.8*0.25);
+    check("diffuse", OutcomeProb(p, kDiffuse), 0.7*0.8*0.65);
+    check("downconverted", OutcomeProb(p, kDownconverted), 0.7*0.8*0.1);
+    check("bounce limit", OutcomeProb(p, kBounceLimit), 0.);
+    check("unknown outcome", OutcomeProb(p, kNOutcomes), 0.);
+
+    // Normalized across the whole parameter space
+    for (double a=0.; a<=1.; a+=0.25)
+        for (double r=0.; r<=1.; r+=0.25)
+            for (double h=0.; h<=1.; h+=0.25)
+                for (double s=0.; s<=1.-h; s+=0.25) {
+                    p.abs = a; p.refl = r; p.anh = h; p.spec = s; p.diff = 1.-h-s;
+                    double sum = 0.;
+                    for (int o=0; o<kNOutcomes; o++) sum += OutcomeProb(p, o);
+                    check("normalization", sum, 1.);
+                }
+
+    // Default surface reflects everything specularly
+    check("default specular", OutcomeProb(Probs(), kSpecular), 1.);
+
+    // One share given: the others keep their ratio and fill the rest
+    p.abs = 0.2; p.refl = 0.9; p.anh = 0.1; p.spec = 0.5; p.diff = 0.4;
+    Probs t = TestProbs(p, { { "spec", 0.8 } });
+    check("given share", t.spec, 0.8);
+    check("scaled anh", t.anh, 0.04);
+    check("scaled diff", t.diff, 0.16);
+    check("unchanged abs", t.abs, 0.2);
+
+    // Given shares above one are scaled to one, others dropped
+    t = TestProbs(p, { { "anh", 0.6 }, { "diff", 0.6 }, { "refl", 0.5 } });
+    check("capped anh", t.anh, 0.5);
+    check("dropped spec", t.spec, 0.);
+    check("changed refl", t.refl, 0.5);
+
+    // No change reproduces the recorded values
+    t = TestProbs(p, {});
+    for (int o=0; o<kNOutcomes; o++)
+        check("identity", OutcomeProb(t, o), OutcomeProb(p, o));
+
+    return failures;
+}
@@ -0,0 +1,78 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  testRunLength.cc
+//
+// Description:	Check the batch-means ratio estimator of PhononRunLength
+//		against hand-computed values.
+//
+// Usage: testRunLength		(returns number of failures)
+
+#include "PhononRunLength.hh"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+
+namespace {
+  G4int failures = 0;
+
+  void check(const char* what, G4double got, G4double expect) {
+    if (std::fabs(got-expect) <= 1e-12*(1.+std::fabs(expect))) return;
+    std::cerr << "FAIL " << what << ": got " << got << ", expected "
+	      << expect << std::endl;
+    failures++;
+  }
+
+  PhononRunLength::Sums batch(G4double num, G4double den) {
+    PhononRunLength::Sums sums;
+    sums.num[PhononRunLength::kKID] = num;
+    sums.den[PhononRunLength::kKID] = den;
+    sums.events = 1;
+    return sums;
+  }
+}
+
+
+int main() {
+  const G4int kid = PhononRunLength::kKID;
+  std::vector<PhononRunLength::Sums> batches;
+  G4double value, error;
+
+  PhononRunLength::Estimate(batches, kid, value, error);
+  check("no batches, value", value, 0.);
+  check("no batches, error", error, 0.);
+
+  batches.push_back(batch(1., 1.));
+  PhononRunLength::Estimate(batches, kid, value, error);
+  check("one batch, value", value, 1.);
+  check("one batch, error", error, 0.);
+
+  // num = {1,2,3}, den = 1: R = 2, z = {-1,0,1}, error = sqrt(2/6)
+  batches.push_back(batch(2., 1.));
+  batches.push_back(batch(3., 1.));
+  PhononRunLength::Estimate(batches, kid, value, error);
+  check("three batches, value", value, 2.);
+  check("three batches, error", error, std::sqrt(1./3.));
+
+  // Exact proportionality has no spread, whatever the denominators
+  batches = { batch(2., 1.), batch(6., 3.), batch(10., 5.) };
+  PhononRunLength::Estimate(batches, kid, value, error);
+  check("proportional, value", value, 2.);
+  check("proportional, error", error, 0.);
+
+  // Ratio of sums, not mean of ratios: (1+9)/(1+3); z = {-1.5,1.5}
+  batches = { batch(1., 1.), batch(9., 3.) };
+  PhononRunLength::Estimate(batches, kid, value, error);
+  check("ratio of sums, value", value, 2.5);
+  check("ratio of sums, error", error, 0.75);
+
+  // Unused estimator has zero denominators
+  PhononRunLength::Estimate(batches, PhononRunLength::kTau, value, error);
+  check("empty estimator, value", value, 0.);
+
+  return failures;
+}
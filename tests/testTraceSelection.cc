@@ -0,0 +1,63 @@
+/***********************************************************************\
+ * This software is licensed under the terms of the GNU General Public *
+ * License version 3 or later. See G4CMP/LICENSE for the full license. *
+\***********************************************************************/
+
+// $Id$
+// File:  testTraceSelection.cc
+//
+// Description:	Check the hash sampling of PhononTrajectoryTracer: limits
+//		of the rate, whole-event selection, and the sampled fraction.
+//
+// Usage: testTraceSelection	(returns number of failures)
+
+#include "PhononTrajectoryTracer.hh"
+#include <cmath>
+#include <iostream>
+
+
+namespace {
+  G4int failures = 0;
+
+  void check(const char* what, G4bool ok) {
+    if (ok) return;
+    std::cerr << "FAIL " << what << std::endl;
+    failures++;
+  }
+}
+
+
+int main() {
+  G4bool allSelected = true, noneSelected = true, eventWide = true;
+  for (G4int event=0; event<100; event++) {
+    G4bool first = PhononTrajectoryTracer::IsSelected(0, event, 1, 3, true);
+    for (G4int track=1; track<=100; track++) {
+      allSelected &= PhononTrajectoryTracer::IsSelected(0, event, track, 1, false);
+      noneSelected &= !PhononTrajectoryTracer::IsSelected(0, event, track, 0, false);
+      eventWide &= (PhononTrajectoryTracer::IsSelected(0, event, track, 3, true) == first);
+    }
+  }
+  check("rate 1 selects every track", allSelected);
+  check("rate 0 selects nothing", noneSelected);
+  check("event mode ignores track ID", eventWide);
+
+  // Sampled fraction is 1/rate to within binomial fluctuations
+  const G4int rate = 10, nEvents = 1000, nTracks = 100;
+  G4int nSelected = 0, nRepeat = 0, nOtherRun = 0;
+  for (G4int event=0; event<nEvents; event++) {
+    for (G4int track=1; track<=nTracks; track++) {
+      G4bool chosen = PhononTrajectoryTracer::IsSelected(4, event, track, rate, false);
+      nSelected += chosen;
+      nRepeat += (chosen == PhononTrajectoryTracer::IsSelected(4, event, track, rate, false));
+      nOtherRun += (chosen && PhononTrajectoryTracer::IsSelected(5, event, track, rate, false));
+    }
+  }
+
+  const G4double n = nEvents*nTracks, p = 1./rate;
+  check("sampled fraction", std::fabs(nSelected - n*p) < 5.*std::sqrt(n*p*(1.-p)));
+  check("selection is reproducible", nRepeat == nEvents*nTracks);
+  check("runs are sampled independently",
+	std::fabs(nOtherRun - n*p*p) < 5.*std::sqrt(n*p*p));
+
+  return failures;
+}